@@ -0,0 +1,310 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Binding of threads to CPUs.
+ */
+
+#define _GNU_SOURCE
+
+#include "affinity.h"
+#include "topology.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <errno.h>
+#include <sched.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * `affinity_type_str()` is a string representing a given way of
+ * binding threads to CPUs.
+ */
+const char * affinity_type_str(
+    enum affinity_type affinity_type)
+{
+    switch (affinity_type) {
+    case affinity_none: return "none";
+    case affinity_compact: return "compact";
+    case affinity_scatter: return "scatter";
+    case affinity_cores: return "cores";
+    case affinity_smt: return "smt";
+    case affinity_list: return "list";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `parse_affinity()` parses a string designating how to bind threads
+ * to CPUs.
+ */
+int parse_affinity(
+    const char * s,
+    struct affinity * affinity)
+{
+    affinity->num_cpus = 0;
+    affinity->cpus = NULL;
+    if (strcmp(s, "none") == 0) {
+        affinity->type = affinity_none;
+    } else if (strcmp(s, "compact") == 0) {
+        affinity->type = affinity_compact;
+    } else if (strcmp(s, "scatter") == 0) {
+        affinity->type = affinity_scatter;
+    } else if (strcmp(s, "cores") == 0) {
+        affinity->type = affinity_cores;
+    } else if (strcmp(s, "smt") == 0) {
+        affinity->type = affinity_smt;
+    } else if (strstr(s, "list:") == s) {
+        const char * list = s + strlen("list:");
+        int num_cpus;
+        int err = parse_cpulist(list, 0, NULL, &num_cpus);
+        if (err)
+            return err;
+        if (num_cpus <= 0)
+            return EINVAL;
+        affinity->cpus = malloc(num_cpus * sizeof(int));
+        if (!affinity->cpus)
+            return errno;
+        err = parse_cpulist(list, num_cpus, affinity->cpus, &num_cpus);
+        if (err) {
+            free(affinity->cpus);
+            affinity->cpus = NULL;
+            return err;
+        }
+        affinity->type = affinity_list;
+        affinity->num_cpus = num_cpus;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `affinity_free()` frees resources associated with a thread binding.
+ */
+void affinity_free(
+    struct affinity * affinity)
+{
+    free(affinity->cpus);
+    affinity->cpus = NULL;
+    affinity->num_cpus = 0;
+}
+
+/**
+ * `compare_compact()` orders CPUs by package, then core, then SMT
+ * sibling.
+ */
+static int compare_compact(
+    const void * a,
+    const void * b)
+{
+    const struct topology_cpu * x = a;
+    const struct topology_cpu * y = b;
+    if (x->package != y->package)
+        return x->package < y->package ? -1 : 1;
+    if (x->core != y->core)
+        return x->core < y->core ? -1 : 1;
+    if (x->thread != y->thread)
+        return x->thread < y->thread ? -1 : 1;
+    return x->cpu < y->cpu ? -1 : (x->cpu > y->cpu);
+}
+
+/**
+ * `compare_scatter()` orders CPUs by SMT sibling, then core, then
+ * package, so that consecutive threads land on different packages.
+ */
+static int compare_scatter(
+    const void * a,
+    const void * b)
+{
+    const struct topology_cpu * x = a;
+    const struct topology_cpu * y = b;
+    if (x->thread != y->thread)
+        return x->thread < y->thread ? -1 : 1;
+    if (x->core != y->core)
+        return x->core < y->core ? -1 : 1;
+    if (x->package != y->package)
+        return x->package < y->package ? -1 : 1;
+    return x->cpu < y->cpu ? -1 : (x->cpu > y->cpu);
+}
+
+/**
+ * `compare_smt()` orders CPUs by SMT sibling, then package, then core,
+ * so that every core receives a thread before any core receives two.
+ */
+static int compare_smt(
+    const void * a,
+    const void * b)
+{
+    const struct topology_cpu * x = a;
+    const struct topology_cpu * y = b;
+    if (x->thread != y->thread)
+        return x->thread < y->thread ? -1 : 1;
+    return compare_compact(a, b);
+}
+
+/**
+ * `affinity_cpus()` assigns a CPU to each of `num_threads` threads.
+ */
+int affinity_cpus(
+    const struct affinity * affinity,
+    const struct topology * topology,
+    int num_threads,
+    int * cpus)
+{
+    if (affinity->type == affinity_list) {
+        for (int i = 0; i < num_threads; i++)
+            cpus[i] = affinity->cpus[i % affinity->num_cpus];
+        return 0;
+    }
+    if (topology->num_cpus <= 0)
+        return EINVAL;
+
+    struct topology_cpu * order = malloc(
+        topology->num_cpus * sizeof(struct topology_cpu));
+    if (!order)
+        return errno;
+    memcpy(order, topology->cpus, topology->num_cpus * sizeof(struct topology_cpu));
+    int num_cpus = topology->num_cpus;
+
+    switch (affinity->type) {
+    case affinity_compact:
+        qsort(order, num_cpus, sizeof(*order), compare_compact);
+        break;
+    case affinity_scatter:
+        qsort(order, num_cpus, sizeof(*order), compare_scatter);
+        break;
+    case affinity_cores:
+        /* Keep only the first SMT sibling of each core. */
+        qsort(order, num_cpus, sizeof(*order), compare_smt);
+        while (num_cpus > 1 && order[num_cpus-1].thread > 0)
+            num_cpus--;
+        break;
+    case affinity_smt:
+        qsort(order, num_cpus, sizeof(*order), compare_smt);
+        break;
+    default:
+        free(order);
+        return EINVAL;
+    }
+
+    for (int i = 0; i < num_threads; i++)
+        cpus[i] = order[i % num_cpus].cpu;
+    free(order);
+    return 0;
+}
+
+/**
+ * `thread_num()` is the OpenMP thread number of the calling thread.
+ */
+static int thread_num(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * `affinity_max_threads()` is the number of threads used in parallel
+ * regions.
+ */
+int affinity_max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/**
+ * `affinity_bind()` binds each thread of subsequent parallel regions
+ * to the CPU `cpus[i]`, where `i` is the thread number.
+ */
+int affinity_bind(
+    int num_threads,
+    const int * cpus)
+{
+    for (int i = 0; i < num_threads; i++) {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+            return EINVAL;
+    }
+
+    int err = 0;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[thread_num()], &set);
+        if (sched_setaffinity(0, sizeof(set), &set)) {
+            int thread_err = errno;
+            #pragma omp critical
+            err = thread_err;
+        }
+    }
+    return err;
+}
+
+/**
+ * `affinity_observe()` records the CPU on which the calling thread is
+ * running.
+ */
+void affinity_observe(
+    int * observed_cpus)
+{
+    observed_cpus[thread_num()] = sched_getcpu();
+}
+
+/**
+ * `affinity_print()` prints the CPU bound to each thread and reports
+ * any thread that was observed running on another CPU.
+ */
+void affinity_print(
+    const struct affinity * affinity,
+    int num_threads,
+    const int * cpus,
+    const int * observed_start,
+    const int * observed_end,
+    FILE * f)
+{
+    fprintf(f, "%s threads:", affinity_type_str(affinity->type));
+    for (int i = 0; i < num_threads; i++)
+        fprintf(f, " %d@cpu%d", i, cpus[i]);
+
+    bool verified = true;
+    for (int i = 0; i < num_threads; i++) {
+        if (observed_start[i] != cpus[i] || observed_end[i] != cpus[i]) {
+            if (verified)
+                fprintf(f, " verified: no (");
+            else
+                fprintf(f, ", ");
+            fprintf(f, "thread %d ran on cpu%d and cpu%d",
+                    i, observed_start[i], observed_end[i]);
+            verified = false;
+        }
+    }
+    fprintf(f, verified ? " verified: yes" : ")");
+}
@@ -0,0 +1,134 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Binding of threads to CPUs.
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include "topology.h"
+
+#include <stdio.h>
+
+/**
+ * `affinity_type` is used to enumerate different ways of binding
+ * threads to CPUs.
+ */
+enum affinity_type
+{
+    affinity_none = 0, /* threads are not bound */
+    affinity_compact,  /* fill SMT siblings, then cores, then packages */
+    affinity_scatter,  /* spread threads evenly across packages */
+    affinity_cores,    /* one thread per physical core */
+    affinity_smt,      /* every core first, then their SMT siblings */
+    affinity_list,     /* an explicit list of CPUs */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_affinity_types
+};
+
+/**
+ * `affinity_type_str()` is a string representing a given way of
+ * binding threads to CPUs.
+ */
+const char * affinity_type_str(
+    enum affinity_type affinity_type);
+
+/**
+ * `affinity` describes how threads are bound to CPUs.
+ */
+struct affinity
+{
+    enum affinity_type type;
+    int num_cpus;
+    int * cpus;
+};
+
+/**
+ * `parse_affinity()` parses a string designating how to bind threads
+ * to CPUs: `compact', `scatter', `cores', `smt' or `list:' followed by
+ * a list of CPUs, such as `list:0,2,4' or `list:0-3'.
+ *
+ * On success, `parse_affinity()` returns `0`. If the string is not
+ * valid, then `parse_affinity()` returns `EINVAL`.
+ */
+int parse_affinity(
+    const char * s,
+    struct affinity * affinity);
+
+/**
+ * `affinity_free()` frees resources associated with a thread binding.
+ */
+void affinity_free(
+    struct affinity * affinity);
+
+/**
+ * `affinity_cpus()` assigns a CPU to each of `num_threads` threads.
+ *
+ * If there are more threads than CPUs, then the CPUs are reused in
+ * the same order.
+ */
+int affinity_cpus(
+    const struct affinity * affinity,
+    const struct topology * topology,
+    int num_threads,
+    int * cpus);
+
+/**
+ * `affinity_max_threads()` is the number of threads used in parallel
+ * regions.
+ */
+int affinity_max_threads(void);
+
+/**
+ * `affinity_bind()` binds each thread of subsequent parallel regions
+ * to the CPU `cpus[i]`, where `i` is the thread number.
+ *
+ * Threads are bound with `sched_setaffinity()`. This relies on the
+ * OpenMP runtime reusing the same threads for parallel regions with
+ * the same number of threads.
+ */
+int affinity_bind(
+    int num_threads,
+    const int * cpus);
+
+/**
+ * `affinity_observe()` records the CPU on which the calling thread is
+ * running in `observed_cpus[i]`, where `i` is the thread number.
+ *
+ * This is cheap enough to be called at the beginning and end of a
+ * benchmark to verify that each thread stayed on its CPU.
+ */
+void affinity_observe(
+    int * observed_cpus);
+
+/**
+ * `affinity_print()` prints the CPU bound to each thread and reports
+ * any thread that was observed running on another CPU.
+ */
+void affinity_print(
+    const struct affinity * affinity,
+    int num_threads,
+    const int * cpus,
+    const int * observed_start,
+    const int * observed_end,
+    FILE * f);
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Memory arenas backed by anonymous memory mappings, optionally using
+ * huge pages.
+ */
+
+#include "arena.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+/**
+ * `hugepages_str()` is a string representing a given kind of huge
+ * pages.
+ */
+const char * hugepages_str(
+    enum hugepages hugepages)
+{
+    switch (hugepages) {
+    case hugepages_none: return "none";
+    case hugepages_thp: return "thp";
+    case hugepages_2m: return "2M";
+    case hugepages_1g: return "1G";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `parse_hugepages()` parses a string designating a kind of huge
+ * pages.
+ *
+ * On success, `parse_hugepages()` returns `0`. If the string does
+ * not correspond to a valid kind of huge pages, then
+ * `parse_hugepages()` returns `EINVAL`.
+ */
+int parse_hugepages(
+    const char * s,
+    enum hugepages * hugepages)
+{
+    if (strcmp(s, "none") == 0) {
+        *hugepages = hugepages_none;
+    } else if (strcmp(s, "thp") == 0) {
+        *hugepages = hugepages_thp;
+    } else if (strcmp(s, "2M") == 0) {
+        *hugepages = hugepages_2m;
+    } else if (strcmp(s, "1G") == 0) {
+        *hugepages = hugepages_1g;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `arena_init()` creates an arena of at least the given size.
+ */
+int arena_init(
+    struct arena * arena,
+    size_t size,
+    enum hugepages hugepages,
+    bool populate)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t page_size;
+    switch (hugepages) {
+    case hugepages_none:
+        page_size = sysconf(_SC_PAGESIZE);
+        break;
+    case hugepages_thp:
+        page_size = 2 * 1024 * 1024;
+        break;
+    case hugepages_2m:
+        page_size = 2 * 1024 * 1024;
+        flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+        break;
+    case hugepages_1g:
+        page_size = 1024 * 1024 * 1024;
+        flags |= MAP_HUGETLB | MAP_HUGE_1GB;
+        break;
+    default:
+        return EINVAL;
+    }
+    if (size == 0)
+        size = 1;
+    size = ((size + page_size-1) / page_size) * page_size;
+
+    if (hugepages == hugepages_thp) {
+        /*
+         * Over-allocate, so that the arena can be aligned to a huge
+         * page boundary, and unmap the excess at either end.
+         */
+        size_t mapped_size = size + page_size;
+        char * p = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED)
+            return errno;
+        char * base = (char *) ((((uintptr_t) p) + page_size-1) & ~(page_size-1));
+        if (base > p)
+            munmap(p, base - p);
+        if (base + size < p + mapped_size)
+            munmap(base + size, (p + mapped_size) - (base + size));
+        if (madvise(base, size, MADV_HUGEPAGE)) {
+            int err = errno;
+            munmap(base, size);
+            return err;
+        }
+        if (populate)
+            memset(base, 0, size);
+        arena->base = base;
+    } else {
+        if (populate)
+            flags |= MAP_POPULATE;
+        void * p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED)
+            return errno;
+        arena->base = p;
+    }
+
+    arena->hugepages = hugepages;
+    arena->page_size = page_size;
+    arena->size = size;
+    arena->offset = 0;
+    return 0;
+}
+
+/**
+ * `arena_free()` unmaps an arena and all the buffers allocated from
+ * it.
+ */
+void arena_free(
+    struct arena * arena)
+{
+    if (arena->base)
+        munmap(arena->base, arena->size);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->offset = 0;
+}
+
+/**
+ * `arena_alloc()` allocates a buffer with the given size and
+ * alignment from an arena.
+ */
+void * arena_alloc(
+    struct arena * arena,
+    size_t size,
+    size_t alignment)
+{
+    if (alignment == 0)
+        alignment = 1;
+    size_t offset = ((arena->offset + alignment-1) / alignment) * alignment;
+    if (offset > arena->size || size > arena->size - offset) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    arena->offset = offset + size;
+    return (char *) arena->base + offset;
+}
+
+/**
+ * `arena_hugepage_size()` returns the number of bytes of the arena
+ * that are currently backed by huge pages.
+ */
+int arena_hugepage_size(
+    const struct arena * arena,
+    size_t * hugepage_size)
+{
+    FILE * f = fopen("/proc/self/smaps", "r");
+    if (!f)
+        return errno;
+
+    /*
+     * Sum the huge page fields of every mapping that overlaps the
+     * arena. The kernel may split the arena into several mappings.
+     */
+    uintptr_t arena_begin = (uintptr_t) arena->base;
+    uintptr_t arena_end = arena_begin + arena->size;
+    bool in_arena = false;
+    size_t size = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long begin, end;
+        unsigned long kb;
+        if (sscanf(line, "%lx-%lx ", &begin, &end) == 2) {
+            in_arena = begin < arena_end && end > arena_begin;
+        } else if (in_arena &&
+                   (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+                    sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1 ||
+                    sscanf(line, "Shared_Hugetlb: %lu kB", &kb) == 1))
+        {
+            size += kb * 1024;
+        }
+    }
+    if (ferror(f)) {
+        int err = errno;
+        fclose(f);
+        return err;
+    }
+    fclose(f);
+    *hugepage_size = size;
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Memory arenas backed by anonymous memory mappings, optionally using
+ * huge pages.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * `hugepages` is used to enumerate different kinds of huge pages that
+ * may back a memory arena.
+ */
+enum hugepages
+{
+    hugepages_none = 0, /* regular pages */
+    hugepages_thp,      /* transparent huge pages */
+    hugepages_2m,       /* 2 MiB pages from hugetlbfs */
+    hugepages_1g,       /* 1 GiB pages from hugetlbfs */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_hugepages
+};
+
+/**
+ * `hugepages_str()` is a string representing a given kind of huge
+ * pages.
+ */
+const char * hugepages_str(
+    enum hugepages hugepages);
+
+/**
+ * `parse_hugepages()` parses a string designating a kind of huge
+ * pages.
+ *
+ * On success, `parse_hugepages()` returns `0`. If the string does
+ * not correspond to a valid kind of huge pages, then
+ * `parse_hugepages()` returns `EINVAL`.
+ */
+int parse_hugepages(
+    const char * s,
+    enum hugepages * hugepages);
+
+/**
+ * `arena` is a region of memory from which buffers are allocated by
+ * incrementing an offset. Buffers are not freed individually, but all
+ * at once when the arena is freed.
+ */
+struct arena
+{
+    enum hugepages hugepages;
+    size_t page_size;
+    void * base;
+    size_t size;
+    size_t offset;
+};
+
+/**
+ * `arena_init()` creates an arena of at least the given size.
+ *
+ * The size is rounded up to a multiple of the page size. For
+ * transparent huge pages, the arena is aligned to a 2 MiB boundary
+ * and marked with `MADV_HUGEPAGE`. For 2 MiB and 1 GiB pages, the
+ * arena is mapped with `MAP_HUGETLB`, which fails with `ENOMEM` if
+ * not enough huge pages are reserved.
+ *
+ * If `populate` is `true`, then the arena is prefaulted by the
+ * calling thread, using `MAP_POPULATE` or, for transparent huge
+ * pages, by writing to it after the call to `madvise()`.
+ */
+int arena_init(
+    struct arena * arena,
+    size_t size,
+    enum hugepages hugepages,
+    bool populate);
+
+/**
+ * `arena_free()` unmaps an arena and all the buffers allocated from
+ * it.
+ */
+void arena_free(
+    struct arena * arena);
+
+/**
+ * `arena_alloc()` allocates a buffer with the given size and
+ * alignment from an arena.
+ *
+ * If there is not enough space left in the arena, `NULL` is returned
+ * and `errno` is set to `ENOMEM`.
+ */
+void * arena_alloc(
+    struct arena * arena,
+    size_t size,
+    size_t alignment);
+
+/**
+ * `arena_hugepage_size()` returns the number of bytes of the arena
+ * that are currently backed by huge pages.
+ *
+ * For transparent huge pages, this is obtained from the
+ * `AnonHugePages` field of `/proc/self/smaps`. For hugetlbfs pages,
+ * the `Private_Hugetlb` and `Shared_Hugetlb` fields are used.
+ */
+int arena_hugepage_size(
+    const struct arena * arena,
+    size_t * hugepage_size);
+
+#endif
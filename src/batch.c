@@ -0,0 +1,219 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Call overhead of math operations on small batches.
+ */
+
+#include "batch.h"
+#include "mathop.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <errno.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * `parse_batch_sizes()` parses a comma-separated list of batch
+ * sizes, such as `1,2,4,8'.
+ */
+int parse_batch_sizes(
+    const char * s,
+    struct batch_sizes * batch_sizes)
+{
+    batch_sizes->num_sizes = 0;
+    while (true) {
+        if (batch_sizes->num_sizes >= BATCH_MAX_SIZES)
+            return EINVAL;
+        char * end;
+        errno = 0;
+        long size = strtol(s, &end, 10);
+        if (end == s || errno || size <= 0 || size > INT32_MAX ||
+            (*end != ',' && *end != '\0'))
+            return EINVAL;
+        batch_sizes->sizes[batch_sizes->num_sizes++] = size;
+        if (*end == '\0')
+            break;
+        s = end+1;
+    }
+    return 0;
+}
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `tsc_read()` reads the time-stamp counter, or, if there is none,
+ * the monotonic clock in nanoseconds.
+ *
+ * The fences keep the surrounding instructions from being reordered
+ * across the read.
+ */
+static inline uint64_t tsc_read(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    uint64_t tsc = __rdtsc();
+    _mm_lfence();
+    return tsc;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000ull + t.tv_nsec;
+#endif
+}
+
+/**
+ * `tsc_ghz()` is the rate of the time-stamp counter in ticks per
+ * nanosecond, measured against `CLOCK_MONOTONIC` over 50 ms.
+ */
+static double tsc_ghz(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint64_t c0 = tsc_read();
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+    } while (timespec_duration(t0, t1) < 0.05);
+    uint64_t c1 = tsc_read();
+    return (c1 - c0) / (1e9 * timespec_duration(t0, t1));
+#else
+    return 1.0;
+#endif
+}
+
+/**
+ * `batch_benchmark()` calls `benchmark_mathop()` repeatedly on the
+ * first few elements of the input, for each batch size in turn.
+ */
+int batch_benchmark(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    int alignment,
+    const struct batch_sizes * batch_sizes,
+    int64_t num_calls,
+    struct batch_result * result)
+{
+    if (num_calls <= 0)
+        return EINVAL;
+    int max_size = 0;
+    for (int i = 0; i < batch_sizes->num_sizes; i++) {
+        if (max_size < batch_sizes->sizes[i])
+            max_size = batch_sizes->sizes[i];
+    }
+    if (max_size > input->size)
+        return EINVAL;
+
+    /*
+     * The result of each batch is written to the start of a buffer
+     * of the largest batch size. The exceptions and errno are
+     * recorded per thread as in the benchmark, so that their cost is
+     * part of the fixed cost of a call.
+     */
+    struct mathop_result y;
+    int err = mathop_result_init(&y, mathop, max_size, alignment);
+    if (err)
+        return err;
+
+    result->tsc_ghz = tsc_ghz();
+    result->num_sizes = batch_sizes->num_sizes;
+    for (int i = 0; i < batch_sizes->num_sizes; i++) {
+        int n = batch_sizes->sizes[i];
+        struct mathop_input x = *input;
+        x.size = n;
+        y.size = n;
+
+        /* Warm up caches and branch predictors before the measurement. */
+        int64_t num_ops = 0;
+        for (int64_t j = 0; !err && j < 1000; j++)
+            err = benchmark_mathop(mathop, &x, &y, &num_ops);
+        if (err)
+            break;
+
+        uint64_t c0 = tsc_read();
+        for (int64_t j = 0; j < num_calls; j++) {
+            err = benchmark_mathop(mathop, &x, &y, &num_ops);
+            if (err)
+                break;
+        }
+        uint64_t c1 = tsc_read();
+        if (err)
+            break;
+        result->sizes[i] = n;
+        result->num_calls[i] = num_calls;
+        result->ns_per_call[i] = (c1 - c0) / result->tsc_ghz / num_calls;
+    }
+    y.size = max_size;
+    mathop_result_free(&y);
+    if (err)
+        return err;
+
+    /* Fit the time per call to a fixed cost plus a cost per element. */
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int m = result->num_sizes;
+    for (int i = 0; i < m; i++) {
+        sx += result->sizes[i];
+        sy += result->ns_per_call[i];
+        sxx += (double) result->sizes[i] * result->sizes[i];
+        sxy += result->sizes[i] * result->ns_per_call[i];
+    }
+    double d = m * sxx - sx * sx;
+    result->ns_per_element = d != 0 ? (m * sxy - sx * sy) / d : 0.0;
+    result->fixed_ns = m > 0 ? (sy - result->ns_per_element * sx) / m : 0.0;
+    return 0;
+}
+
+/**
+ * `batch_print()` prints the time per call and per element for each
+ * batch size.
+ */
+void batch_print(
+    enum mathop mathop,
+    const struct batch_result * result,
+    FILE * f)
+{
+    for (int i = 0; i < result->num_sizes; i++) {
+        double fixed = result->fixed_ns > 0 ? result->fixed_ns : 0.0;
+        double ns = result->ns_per_call[i];
+        fprintf(f, "batch: %s %d elements: %.2f ns/call %.3f ns/elem "
+                "(fixed cost %.1f%% of call)\n",
+                mathop_str(mathop), result->sizes[i], ns, ns / result->sizes[i],
+                ns > 0 ? 100.0 * (fixed < ns ? fixed : ns) / ns : 0.0);
+    }
+    fprintf(f, "batch: %s fixed cost: %.2f ns/call marginal cost: %.3f ns/elem "
+            "(%.3f GHz time-stamp counter)\n",
+            mathop_str(mathop), result->fixed_ns, result->ns_per_element,
+            result->tsc_ghz);
+}
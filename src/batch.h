@@ -0,0 +1,97 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Call overhead of math operations on small batches.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "mathop.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define BATCH_MAX_SIZES 32
+
+/**
+ * `batch_sizes` is a list of numbers of elements per call.
+ */
+struct batch_sizes
+{
+    int num_sizes;
+    int sizes[BATCH_MAX_SIZES];
+};
+
+/**
+ * `parse_batch_sizes()` parses a comma-separated list of batch
+ * sizes, such as `1,2,4,8'.
+ *
+ * On success, `parse_batch_sizes()` returns `0`. If the string is
+ * not valid, or a batch size is not positive, then
+ * `parse_batch_sizes()` returns `EINVAL`.
+ */
+int parse_batch_sizes(
+    const char * s,
+    struct batch_sizes * batch_sizes);
+
+/**
+ * `batch_result` is the time taken per call of `benchmark_mathop()`
+ * for each batch size, and a least-squares fit of the time per call
+ * as a fixed cost plus a cost per element.
+ */
+struct batch_result
+{
+    int num_sizes;
+    int sizes[BATCH_MAX_SIZES];
+    int64_t num_calls[BATCH_MAX_SIZES];
+    double ns_per_call[BATCH_MAX_SIZES];
+    double tsc_ghz;
+    double fixed_ns;
+    double ns_per_element;
+};
+
+/**
+ * `batch_benchmark()` calls `benchmark_mathop()` repeatedly on the
+ * first few elements of the input, for each batch size in turn.
+ *
+ * The calls are made by the calling thread alone, outside of any
+ * parallel region, so that the elements and results of a batch stay
+ * in the L1 cache. Each batch size is called `num_calls` times, and
+ * the calls are timed with the time-stamp counter, if available, or
+ * with `CLOCK_MONOTONIC`.
+ */
+int batch_benchmark(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    int alignment,
+    const struct batch_sizes * batch_sizes,
+    int64_t num_calls,
+    struct batch_result * result);
+
+/**
+ * `batch_print()` prints the time per call and per element for each
+ * batch size.
+ */
+void batch_print(
+    enum mathop mathop,
+    const struct batch_result * result,
+    FILE * f);
+
+#endif
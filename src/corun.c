@@ -0,0 +1,363 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Concurrent benchmarks of different math operations on different
+ * CPUs.
+ */
+
+#define _GNU_SOURCE
+
+#include "corun.h"
+#include "mathop.h"
+#include "round.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * `parse_corun()` parses a comma-separated list of math operations
+ * and CPUs, such as `exp@0,sqrt@1'.
+ */
+int parse_corun(
+    const char * s,
+    struct corun * corun)
+{
+    int num_tasks = 1;
+    for (const char * t = s; *t != '\0'; t++) {
+        if (*t == ',')
+            num_tasks++;
+    }
+
+    char * list = strdup(s);
+    if (!list)
+        return errno;
+    struct corun_task * tasks = malloc(num_tasks * sizeof(struct corun_task));
+    if (!tasks) {
+        free(list);
+        return errno;
+    }
+
+    char * saveptr;
+    char * task = strtok_r(list, ",", &saveptr);
+    int i = 0;
+    for (; task && i < num_tasks; i++, task = strtok_r(NULL, ",", &saveptr)) {
+        char * at = strchr(task, '@');
+        if (!at)
+            break;
+        *at = '\0';
+        if (parse_mathop(task, &tasks[i].mathop))
+            break;
+        char * end;
+        errno = 0;
+        long cpu = strtol(at+1, &end, 10);
+        if (end == at+1 || *end != '\0' || errno || cpu < 0 || cpu >= CPU_SETSIZE)
+            break;
+        tasks[i].cpu = cpu;
+    }
+    free(list);
+    if (i != num_tasks) {
+        free(tasks);
+        return EINVAL;
+    }
+    corun->num_tasks = num_tasks;
+    corun->tasks = tasks;
+    return 0;
+}
+
+/**
+ * `corun_free()` frees resources associated with a set of concurrent
+ * math operations.
+ */
+void corun_free(
+    struct corun * corun)
+{
+    free(corun->tasks);
+    corun->tasks = NULL;
+    corun->num_tasks = 0;
+}
+
+/**
+ * `corun_thread` is the state of a thread that benchmarks one math
+ * operation.
+ */
+struct corun_thread
+{
+    const struct corun_task * task;
+    const struct mathop_input * values;
+    int alignment;
+    enum round_mode rounding_mode;
+    int repeat;
+    int64_t min_ops;
+    int num_threads;
+    atomic_int * num_ready;
+    atomic_int * start;
+    atomic_int * num_finished;
+    struct corun_stats stats;
+    int err;
+};
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `corun_thread_main()` binds the calling thread to its CPU, sets up
+ * input and results, and benchmarks a math operation.
+ */
+static void * corun_thread_main(
+    void * arg)
+{
+    struct corun_thread * thread = arg;
+    struct mathop_input input;
+    struct mathop_result result;
+    bool have_input = false, have_result = false;
+    int err = 0;
+
+    /*
+     * Bind the thread and allocate buffers from it. The benchmark
+     * kernels use orphaned worksharing loops, which are executed by
+     * this thread alone, since it is not part of a parallel region.
+     */
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(thread->task->cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set))
+        err = errno;
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    if (!err)
+        err = set_round_mode(thread->rounding_mode);
+    if (!err) {
+        err = mathop_input_copy(
+            &input, thread->task->mathop, thread->values, thread->alignment);
+        have_input = !err;
+    }
+    if (!err) {
+        err = mathop_result_init(
+            &result, thread->task->mathop, input.size, thread->alignment);
+        have_result = !err;
+    }
+
+    /* Warm up caches before the measurement. */
+    int64_t num_ops = 0;
+    if (!err)
+        err = benchmark_mathop(thread->task->mathop, &input, &result, &num_ops);
+
+    /*
+     * Start the measurement together with the other threads, or give
+     * up if not all threads could be created.
+     */
+    atomic_fetch_add(thread->num_ready, 1);
+    while (atomic_load(thread->start) == 0)
+        sched_yield();
+    if (atomic_load(thread->start) < 0 && !err)
+        err = EAGAIN;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int repeat = 0;
+    num_ops = 0;
+    if (!err) {
+        for (; (repeat < thread->repeat) || (num_ops < thread->min_ops); repeat++) {
+            err = benchmark_mathop(thread->task->mathop, &input, &result, &num_ops);
+            if (err)
+                break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    thread->stats.repeat = repeat;
+    thread->stats.num_ops = num_ops;
+    thread->stats.seconds = timespec_duration(t0, t1);
+
+    /* Keep the CPU busy until every thread is finished. */
+    atomic_fetch_add(thread->num_finished, 1);
+    while (!err && atomic_load(thread->num_finished) < thread->num_threads) {
+        int64_t unused_ops = 0;
+        err = benchmark_mathop(thread->task->mathop, &input, &result, &unused_ops);
+    }
+
+    if (have_result)
+        mathop_result_free(&result);
+    if (have_input)
+        mathop_input_free(&input);
+    thread->err = err;
+    return NULL;
+}
+
+/**
+ * `corun_run()` benchmarks a set of math operations concurrently.
+ */
+static int corun_run(
+    int num_tasks,
+    const struct corun_task * tasks,
+    const struct mathop_input * values,
+    int alignment,
+    enum round_mode rounding_mode,
+    int repeat,
+    int64_t min_ops,
+    struct corun_stats * stats)
+{
+    int err;
+    struct corun_thread * threads = malloc(num_tasks * sizeof(struct corun_thread));
+    if (!threads)
+        return errno;
+    pthread_t * ids = malloc(num_tasks * sizeof(pthread_t));
+    if (!ids) {
+        free(threads);
+        return errno;
+    }
+    atomic_int num_ready = 0;
+    atomic_int start = 0;
+    atomic_int num_finished = 0;
+
+    for (int i = 0; i < num_tasks; i++) {
+        threads[i].task = &tasks[i];
+        threads[i].values = values;
+        threads[i].alignment = alignment;
+        threads[i].rounding_mode = rounding_mode;
+        threads[i].repeat = repeat;
+        threads[i].min_ops = min_ops;
+        threads[i].num_threads = num_tasks;
+        threads[i].num_ready = &num_ready;
+        threads[i].start = &start;
+        threads[i].num_finished = &num_finished;
+        threads[i].err = 0;
+    }
+
+    /*
+     * Release the threads once all of them are ready. If a thread
+     * cannot be created, the threads that were created are told to
+     * stop instead.
+     */
+    int num_threads = 0;
+    for (; num_threads < num_tasks; num_threads++) {
+        err = pthread_create(
+            &ids[num_threads], NULL, corun_thread_main, &threads[num_threads]);
+        if (err)
+            break;
+    }
+    if (num_threads == num_tasks) {
+        while (atomic_load(&num_ready) < num_tasks)
+            sched_yield();
+        atomic_store(&start, 1);
+    } else {
+        atomic_store(&start, -1);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(ids[i], NULL);
+        if (!err)
+            err = threads[i].err;
+        stats[i] = threads[i].stats;
+    }
+    free(ids);
+    free(threads);
+    return err;
+}
+
+/**
+ * `corun_benchmark()` benchmarks each math operation alone on its
+ * CPU, and then all of them concurrently.
+ */
+int corun_benchmark(
+    const struct corun * corun,
+    const struct mathop_input * values,
+    int alignment,
+    enum round_mode rounding_mode,
+    int repeat,
+    int64_t min_ops,
+    struct corun_result * results)
+{
+    int err;
+    struct corun_stats * stats = malloc(corun->num_tasks * sizeof(struct corun_stats));
+    if (!stats)
+        return errno;
+
+    for (int i = 0; i < corun->num_tasks; i++) {
+        err = corun_run(
+            1, &corun->tasks[i], values, alignment, rounding_mode,
+            repeat, min_ops, &results[i].solo);
+        if (err) {
+            free(stats);
+            return err;
+        }
+    }
+
+    err = corun_run(
+        corun->num_tasks, corun->tasks, values, alignment, rounding_mode,
+        repeat, min_ops, stats);
+    if (err) {
+        free(stats);
+        return err;
+    }
+    for (int i = 0; i < corun->num_tasks; i++)
+        results[i].corun = stats[i];
+    free(stats);
+    return 0;
+}
+
+/**
+ * `corun_stats_throughput()` is the throughput in millions of
+ * operations per second.
+ */
+static double corun_stats_throughput(
+    const struct corun_stats * stats)
+{
+    return stats->seconds > 0
+        ? (double) stats->num_ops / stats->seconds / 1000000.0 : 0.0;
+}
+
+/**
+ * `corun_print()` prints the throughput of each math operation alone
+ * and when running concurrently with the others.
+ */
+void corun_print(
+    const struct corun * corun,
+    const struct corun_result * results,
+    FILE * f)
+{
+    for (int i = 0; i < corun->num_tasks; i++) {
+        double solo = corun_stats_throughput(&results[i].solo);
+        double concurrent = corun_stats_throughput(&results[i].corun);
+        fprintf(f, "corun: %s@cpu%d solo: %.6f Mops/s "
+                "corun: %.6f Mops/s (%.1f%% of solo)\n",
+                mathop_str(corun->tasks[i].mathop), corun->tasks[i].cpu,
+                solo, concurrent, solo > 0 ? 100.0 * concurrent / solo : 0.0);
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Concurrent benchmarks of different math operations on different
+ * CPUs.
+ */
+
+#ifndef CORUN_H
+#define CORUN_H
+
+#include "mathop.h"
+#include "round.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `corun_task` is a math operation that is benchmarked on a given
+ * CPU.
+ */
+struct corun_task
+{
+    enum mathop mathop;
+    int cpu;
+};
+
+/**
+ * `corun` is a set of math operations that are benchmarked
+ * concurrently.
+ */
+struct corun
+{
+    int num_tasks;
+    struct corun_task * tasks;
+};
+
+/**
+ * `parse_corun()` parses a comma-separated list of math operations
+ * and CPUs, such as `exp@0,sqrt@1'.
+ *
+ * On success, `parse_corun()` returns `0`. If the string is not
+ * valid, then `parse_corun()` returns `EINVAL`.
+ */
+int parse_corun(
+    const char * s,
+    struct corun * corun);
+
+/**
+ * `corun_free()` frees resources associated with a set of concurrent
+ * math operations.
+ */
+void corun_free(
+    struct corun * corun);
+
+/**
+ * `corun_stats` is the outcome of benchmarking a math operation on
+ * one CPU.
+ */
+struct corun_stats
+{
+    int repeat;
+    int64_t num_ops;
+    double seconds;
+};
+
+/**
+ * `corun_result` compares the throughput of a math operation when it
+ * runs alone with its throughput when it runs concurrently with the
+ * other math operations.
+ */
+struct corun_result
+{
+    struct corun_stats solo;
+    struct corun_stats corun;
+};
+
+/**
+ * `corun_benchmark()` benchmarks each math operation alone on its
+ * CPU, and then all of them concurrently.
+ *
+ * Each math operation runs in its own thread, which is bound to the
+ * given CPU, and has its own input and result buffers. The input is
+ * a copy of `values`, converted to the input type of the operation,
+ * and it is allocated by the thread that uses it. The threads start
+ * the measurement together, and every thread keeps running its
+ * operation, without measuring it, until all threads are done. Thus,
+ * the measured time of every operation overlaps fully with the other
+ * operations.
+ *
+ * `results` must have room for one result per task.
+ */
+int corun_benchmark(
+    const struct corun * corun,
+    const struct mathop_input * values,
+    int alignment,
+    enum round_mode rounding_mode,
+    int repeat,
+    int64_t min_ops,
+    struct corun_result * results);
+
+/**
+ * `corun_print()` prints the throughput of each math operation alone
+ * and when running concurrently with the others.
+ */
+void corun_print(
+    const struct corun * corun,
+    const struct corun_result * results,
+    FILE * f);
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Overhead of different ways of calling math functions.
+ */
+
+#include "dispatch.h"
+#include "dispatchinline.h"
+#include "mathop.h"
+
+#include <errno.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * `dispatch_str()` is a string representing a given way of calling a
+ * math function.
+ */
+const char * dispatch_str(
+    enum dispatch dispatch)
+{
+    switch (dispatch) {
+    case dispatch_direct: return "direct";
+    case dispatch_pointer: return "pointer";
+    case dispatch_plt: return "plt";
+    case dispatch_inline: return "inline";
+    default: return "unknown";
+    }
+}
+
+/*
+ * Kernels that call a math function directly, through a function
+ * pointer and through the PLT. The direct calls are those of the
+ * kernels of `benchmark_mathop()', without its bookkeeping of
+ * exceptions, so that every way of calling the function is measured
+ * with the same bare loop. The function pointers are volatile, so
+ * that the compiler cannot resolve the call, and the PLT symbols are
+ * declared under another name with the assembler name of the library
+ * function, so that the compiler does not recognise them as builtins.
+ * The kernels that call builtins are in `dispatchinline.c'.
+ */
+
+typedef int (* dispatch_kernel_float)(
+    int64_t, const float * restrict, struct mathop_result * restrict);
+typedef int (* dispatch_kernel_double)(
+    int64_t, const double * restrict, struct mathop_result * restrict);
+
+#define dispatch_fn(OPNAME, TYPE, RESULT_TYPE, FIELD)                   \
+    static TYPE (* volatile dispatch_pointer_fn_ ## OPNAME)(TYPE) = OPNAME; \
+    extern TYPE dispatch_plt_fn_ ## OPNAME(TYPE) __asm__(#OPNAME);      \
+                                                                        \
+    static int dispatch_direct_ ## OPNAME(                              \
+        int64_t N,                                                      \
+        const TYPE * restrict x,                                        \
+        struct mathop_result * restrict result)                         \
+    {                                                                   \
+        if (N != result->size || result->type != RESULT_TYPE)           \
+            return EINVAL;                                              \
+        _Pragma("omp for simd schedule(static)")                        \
+        for (int64_t i = 0; i < N; i++)                                 \
+            result->FIELD[i] = OPNAME(x[i]);                            \
+        return 0;                                                       \
+    }                                                                   \
+                                                                        \
+    static int dispatch_pointer_ ## OPNAME(                             \
+        int64_t N,                                                      \
+        const TYPE * restrict x,                                        \
+        struct mathop_result * restrict result)                         \
+    {                                                                   \
+        if (N != result->size || result->type != RESULT_TYPE)           \
+            return EINVAL;                                              \
+        TYPE (* fn)(TYPE) = dispatch_pointer_fn_ ## OPNAME;             \
+        _Pragma("omp for simd schedule(static)")                        \
+        for (int64_t i = 0; i < N; i++)                                 \
+            result->FIELD[i] = fn(x[i]);                                \
+        return 0;                                                       \
+    }                                                                   \
+                                                                        \
+    static int dispatch_plt_ ## OPNAME(                                 \
+        int64_t N,                                                      \
+        const TYPE * restrict x,                                        \
+        struct mathop_result * restrict result)                         \
+    {                                                                   \
+        if (N != result->size || result->type != RESULT_TYPE)           \
+            return EINVAL;                                              \
+        _Pragma("omp for simd schedule(static)")                        \
+        for (int64_t i = 0; i < N; i++)                                 \
+            result->FIELD[i] = dispatch_plt_fn_ ## OPNAME(x[i]);        \
+        return 0;                                                       \
+    }                                                                   \
+
+#define dispatch_fn_float(OPNAME) \
+    dispatch_fn(OPNAME, float, mathop_result_f32, f32)
+#define dispatch_fn_double(OPNAME) \
+    dispatch_fn(OPNAME, double, mathop_result_f64, f64)
+
+#define dispatch_fn_type(OPNAME, TYPE) dispatch_fn_ ## TYPE(OPNAME)
+mathop_fns(dispatch_fn_type)
+
+/**
+ * `dispatch_kernels` holds the kernels of a math operation for each
+ * way of calling it, except `dispatch_inline'.
+ */
+struct dispatch_kernels
+{
+    dispatch_kernel_float f32[num_dispatches];
+    dispatch_kernel_double f64[num_dispatches];
+};
+
+#define dispatch_kernels_float(OPNAME)                                  \
+    [mathop_ ## OPNAME] = { .f32 = {                                    \
+            [dispatch_direct] = dispatch_direct_ ## OPNAME,             \
+            [dispatch_pointer] = dispatch_pointer_ ## OPNAME,           \
+            [dispatch_plt] = dispatch_plt_ ## OPNAME } },
+#define dispatch_kernels_double(OPNAME)                                 \
+    [mathop_ ## OPNAME] = { .f64 = {                                    \
+            [dispatch_direct] = dispatch_direct_ ## OPNAME,             \
+            [dispatch_pointer] = dispatch_pointer_ ## OPNAME,           \
+            [dispatch_plt] = dispatch_plt_ ## OPNAME } },
+#define dispatch_kernels_type(OPNAME, TYPE) dispatch_kernels_ ## TYPE(OPNAME)
+
+static const struct dispatch_kernels dispatch_kernels[num_mathops] = {
+    mathop_fns(dispatch_kernels_type)
+};
+
+/**
+ * `benchmark_dispatch()` benchmarks a math operation with the same
+ * loop structure, threading and buffers as `benchmark_mathop()`, but
+ * calls the math function in the given way.
+ */
+int benchmark_dispatch(
+    enum mathop mathop,
+    enum dispatch dispatch,
+    struct mathop_input * input,
+    struct mathop_result * result,
+    int64_t * num_ops)
+{
+    if (mathop < 0 || mathop >= num_mathops ||
+        dispatch < 0 || dispatch >= num_dispatches)
+        return EINVAL;
+
+    int err;
+    errno = 0;
+    const struct dispatch_kernels * kernels = &dispatch_kernels[mathop];
+    if (dispatch == dispatch_inline) {
+        err = benchmark_dispatch_inline(mathop, input, result);
+    } else if (input->type == mathop_input_f32 && kernels->f32[dispatch]) {
+        err = kernels->f32[dispatch](input->size, input->f32, result);
+    } else if (input->type == mathop_input_f64 && kernels->f64[dispatch]) {
+        err = kernels->f64[dispatch](input->size, input->f64, result);
+    } else {
+        return EINVAL;
+    }
+    if (err)
+        return err;
+    if ((math_errhandling & MATH_ERRNO) && errno)
+        return errno;
+    (*num_ops) += input->size;
+    return 0;
+}
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `dispatch_round()` benchmarks one way of calling a math operation
+ * once over the input, in a parallel region.
+ */
+static int dispatch_round(
+    enum mathop mathop,
+    enum dispatch dispatch,
+    struct mathop_input * input,
+    struct mathop_result * result,
+    int64_t * num_ops,
+    double * seconds)
+{
+    int err = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    #pragma omp parallel
+    {
+        int64_t thread_ops = 0;
+        int thread_err = benchmark_dispatch(
+            mathop, dispatch, input, result, &thread_ops);
+        #pragma omp critical
+        {
+            if (thread_err && !err)
+                err = thread_err;
+        }
+        #pragma omp master
+        *num_ops += thread_ops;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    *seconds += timespec_duration(t0, t1);
+    return err;
+}
+
+/**
+ * `dispatch_benchmark()` benchmarks every way of calling a math
+ * operation, in `repeat` interleaved rounds over the input.
+ */
+int dispatch_benchmark(
+    enum mathop mathop,
+    struct mathop_input * input,
+    int alignment,
+    int repeat,
+    struct dispatch_result * result)
+{
+    if (repeat < 1)
+        repeat = 1;
+    struct mathop_result y;
+    int err = mathop_result_init(&y, mathop, input->size, alignment);
+    if (err)
+        return err;
+
+    /* Warm up caches before the measurement. */
+    int64_t num_ops = 0;
+    double seconds = 0;
+    for (int d = 0; !err && d < num_dispatches; d++)
+        err = dispatch_round(mathop, d, input, &y, &num_ops, &seconds);
+
+    result->repeat = repeat;
+    for (int d = 0; d < num_dispatches; d++) {
+        result->num_ops[d] = 0;
+        result->seconds[d] = 0;
+    }
+    for (int i = 0; !err && i < repeat; i++) {
+        for (int d = 0; !err && d < num_dispatches; d++) {
+            err = dispatch_round(
+                mathop, d, input, &y, &result->num_ops[d], &result->seconds[d]);
+        }
+    }
+    mathop_result_free(&y);
+    return err;
+}
+
+/**
+ * `dispatch_print()` prints the throughput and time per operation of
+ * each way of calling a math function, and the difference from
+ * calling it directly.
+ */
+void dispatch_print(
+    enum mathop mathop,
+    const struct dispatch_result * result,
+    FILE * f)
+{
+    double direct = result->num_ops[dispatch_direct] > 0
+        ? 1e9 * result->seconds[dispatch_direct] / result->num_ops[dispatch_direct]
+        : 0.0;
+    for (int d = 0; d < num_dispatches; d++) {
+        double ns = result->num_ops[d] > 0
+            ? 1e9 * result->seconds[d] / result->num_ops[d] : 0.0;
+        fprintf(f, "dispatch: %s %s: %.6f Mops/s %.3f ns/op (%+.3f ns/op)\n",
+                mathop_str(mathop), dispatch_str(d),
+                result->seconds[d] > 0
+                ? (double) result->num_ops[d] / result->seconds[d] / 1000000.0 : 0.0,
+                ns, ns - direct);
+    }
+    fprintf(f, "dispatch: %s inline is compiled without errno, "
+            "the other ways keep errno semantics\n", mathop_str(mathop));
+}
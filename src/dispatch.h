@@ -0,0 +1,112 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Overhead of different ways of calling math functions.
+ */
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "mathop.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `dispatch` is used to enumerate different ways of calling a math
+ * function from the benchmark kernels.
+ */
+enum dispatch
+{
+    dispatch_direct = 0, /* a direct call, as in benchmark_mathop() */
+    dispatch_pointer,    /* an indirect call through a function pointer */
+    dispatch_plt,        /* a call to the library symbol through the PLT */
+    dispatch_inline,     /* a builtin, inlined by the compiler where possible */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_dispatches
+};
+
+/**
+ * `dispatch_str()` is a string representing a given way of calling a
+ * math function.
+ */
+const char * dispatch_str(
+    enum dispatch dispatch);
+
+/**
+ * `benchmark_dispatch()` benchmarks a math operation with the same
+ * loop structure, threading and buffers as `benchmark_mathop()`, but
+ * calls the math function in the given way.
+ *
+ * A call through the PLT goes to the symbol exported by the math
+ * library, which the dynamic linker may have resolved to a
+ * CPU-specific implementation through an IFUNC, and which the
+ * compiler cannot replace by inline code. The inlined kernels are
+ * compiled without `errno', so that functions such as `sqrt' may
+ * become single instructions. Every way of calling a function,
+ * including `dispatch_direct', uses a bare loop without the
+ * bookkeeping of exceptions of `benchmark_mathop()`, so that only the
+ * call itself differs.
+ *
+ * Like `benchmark_mathop()`, `benchmark_dispatch()` returns the value
+ * of `errno' if a math function sets it. It is called by each thread
+ * of a parallel region, and it returns the error of the calling
+ * thread only.
+ */
+int benchmark_dispatch(
+    enum mathop mathop,
+    enum dispatch dispatch,
+    struct mathop_input * input,
+    struct mathop_result * result,
+    int64_t * num_ops);
+
+/**
+ * `dispatch_result` is the time taken by each way of calling a math
+ * function.
+ */
+struct dispatch_result
+{
+    int repeat;
+    int64_t num_ops[num_dispatches];
+    double seconds[num_dispatches];
+};
+
+/**
+ * `dispatch_benchmark()` benchmarks every way of calling a math
+ * operation, in `repeat` interleaved rounds over the input.
+ */
+int dispatch_benchmark(
+    enum mathop mathop,
+    struct mathop_input * input,
+    int alignment,
+    int repeat,
+    struct dispatch_result * result);
+
+/**
+ * `dispatch_print()` prints the throughput and time per operation of
+ * each way of calling a math function, and the difference from
+ * calling it directly.
+ */
+void dispatch_print(
+    enum mathop mathop,
+    const struct dispatch_result * result,
+    FILE * f);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Math functions called as builtins that the compiler may inline.
+ */
+
+#include "dispatchinline.h"
+#include "mathop.h"
+
+#include <errno.h>
+
+#include <math.h>
+#include <stdint.h>
+
+/*
+ * Kernels that call a math function as a builtin. This file is
+ * compiled with `-fno-math-errno'.
+ */
+
+typedef int (* dispatch_inline_kernel_float)(
+    int64_t, const float * restrict, struct mathop_result * restrict);
+typedef int (* dispatch_inline_kernel_double)(
+    int64_t, const double * restrict, struct mathop_result * restrict);
+
+#define dispatch_inline_fn(OPNAME, TYPE, RESULT_TYPE, FIELD)            \
+    static int dispatch_inline_ ## OPNAME(                              \
+        int64_t N,                                                      \
+        const TYPE * restrict x,                                        \
+        struct mathop_result * restrict result)                         \
+    {                                                                   \
+        if (N != result->size || result->type != RESULT_TYPE)           \
+            return EINVAL;                                              \
+        _Pragma("omp for simd schedule(static)")                        \
+        for (int64_t i = 0; i < N; i++)                                 \
+            result->FIELD[i] = __builtin_ ## OPNAME(x[i]);              \
+        return 0;                                                       \
+    }                                                                   \
+
+#define dispatch_inline_fn_float(OPNAME) \
+    dispatch_inline_fn(OPNAME, float, mathop_result_f32, f32)
+#define dispatch_inline_fn_double(OPNAME) \
+    dispatch_inline_fn(OPNAME, double, mathop_result_f64, f64)
+
+#define dispatch_inline_fn_type(OPNAME, TYPE) \
+    dispatch_inline_fn_ ## TYPE(OPNAME)
+mathop_fns(dispatch_inline_fn_type)
+
+/**
+ * `dispatch_inline_kernels` holds the kernel of each math operation.
+ */
+struct dispatch_inline_kernels
+{
+    dispatch_inline_kernel_float f32;
+    dispatch_inline_kernel_double f64;
+};
+
+#define dispatch_inline_kernels_float(OPNAME)                           \
+    [mathop_ ## OPNAME] = { .f32 = dispatch_inline_ ## OPNAME },
+#define dispatch_inline_kernels_double(OPNAME)                          \
+    [mathop_ ## OPNAME] = { .f64 = dispatch_inline_ ## OPNAME },
+#define dispatch_inline_kernels_type(OPNAME, TYPE) \
+    dispatch_inline_kernels_ ## TYPE(OPNAME)
+
+static const struct dispatch_inline_kernels dispatch_inline_kernels[num_mathops] = {
+    mathop_fns(dispatch_inline_kernels_type)
+};
+
+/**
+ * `benchmark_dispatch_inline()` computes a math operation for every
+ * input element, calling the math function as a builtin.
+ */
+int benchmark_dispatch_inline(
+    enum mathop mathop,
+    struct mathop_input * input,
+    struct mathop_result * result)
+{
+    if (mathop < 0 || mathop >= num_mathops)
+        return EINVAL;
+    const struct dispatch_inline_kernels * kernels = &dispatch_inline_kernels[mathop];
+    if (input->type == mathop_input_f32 && kernels->f32)
+        return kernels->f32(input->size, input->f32, result);
+    if (input->type == mathop_input_f64 && kernels->f64)
+        return kernels->f64(input->size, input->f64, result);
+    return EINVAL;
+}
@@ -0,0 +1,46 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Math functions called as builtins that the compiler may inline.
+ */
+
+#ifndef DISPATCHINLINE_H
+#define DISPATCHINLINE_H
+
+#include "mathop.h"
+
+/**
+ * `benchmark_dispatch_inline()` computes a math operation for every
+ * input element, calling the math function as a builtin.
+ *
+ * The kernels are in a translation unit of their own, which is
+ * compiled without `errno', so that functions such as `sqrt' may
+ * become single instructions, whereas the other ways of calling a
+ * math function keep the semantics of `errno'. The kernels use the
+ * same orphaned worksharing loop as `benchmark_mathop()`.
+ *
+ * If there is no kernel for the math operation and input type, then
+ * `EINVAL` is returned.
+ */
+int benchmark_dispatch_inline(
+    enum mathop mathop,
+    struct mathop_input * input,
+    struct mathop_result * result);
+
+#endif
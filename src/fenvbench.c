@@ -0,0 +1,281 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Microbenchmarks for the cost of floating-point environment calls.
+ */
+
+#include "fenvbench.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <errno.h>
+
+#include <fenv.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * `fenv_call_str()` is a string representing a given floating-point
+ * environment function.
+ */
+const char * fenv_call_str(
+    enum fenv_call fenv_call)
+{
+    switch (fenv_call) {
+    case fenv_fegetround: return "fegetround";
+    case fenv_fesetround: return "fesetround";
+    case fenv_feclearexcept: return "feclearexcept";
+    case fenv_fegetexceptflag: return "fegetexceptflag";
+    case fenv_fesetexceptflag: return "fesetexceptflag";
+    case fenv_fetestexcept: return "fetestexcept";
+    case fenv_fegetenv: return "fegetenv";
+    case fenv_fesetenv: return "fesetenv";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `fenv_state` is the floating-point environment of a thread when the
+ * measurement started, which the measured calls set again or read
+ * into scratch space, so that the environment is left unchanged. The
+ * measured calls take all of their arguments from it, so that their
+ * arguments depend on the address used to reach it.
+ */
+struct fenv_state
+{
+    int excepts;
+    int round;
+    fexcept_t flags;
+    fenv_t env;
+    fexcept_t scratch_flags;
+    fenv_t scratch_env;
+};
+
+/*
+ * Each function is called through a wrapper with the same signature,
+ * so that the cost of the indirect call can be measured with an empty
+ * wrapper and subtracted.
+ */
+typedef int (* fenv_call_fn)(struct fenv_state *);
+
+static int call_none(struct fenv_state * s) { return 0; }
+static int call_fegetround(struct fenv_state * s) { return fegetround(); }
+static int call_fesetround(struct fenv_state * s) { return fesetround(s->round); }
+static int call_feclearexcept(struct fenv_state * s) { return feclearexcept(s->excepts); }
+static int call_fegetexceptflag(struct fenv_state * s) { return fegetexceptflag(&s->scratch_flags, s->excepts); }
+static int call_fesetexceptflag(struct fenv_state * s) { return fesetexceptflag(&s->flags, s->excepts); }
+static int call_fetestexcept(struct fenv_state * s) { return fetestexcept(s->excepts); }
+static int call_fegetenv(struct fenv_state * s) { return fegetenv(&s->scratch_env); }
+static int call_fesetenv(struct fenv_state * s) { return fesetenv(&s->env); }
+
+static const fenv_call_fn fenv_call_fns[num_fenv_calls] = {
+    call_fegetround,
+    call_fesetround,
+    call_feclearexcept,
+    call_fegetexceptflag,
+    call_fesetexceptflag,
+    call_fetestexcept,
+    call_fegetenv,
+    call_fesetenv,
+};
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `time_throughput()` is the time taken to call a function
+ * back-to-back.
+ */
+static double time_throughput(
+    fenv_call_fn fn,
+    struct fenv_state * s,
+    int64_t num_calls,
+    volatile int * sink)
+{
+    struct timespec t0, t1;
+    int x = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int64_t i = 0; i < num_calls; i++)
+        x += fn(s);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    *sink = x;
+    return timespec_duration(t0, t1);
+}
+
+/*
+ * `fenv_zero` is zero, but the compiler cannot know it, so that
+ * masking a value with it gives a zero that depends on the value.
+ */
+static volatile int fenv_zero = 0;
+
+/**
+ * `time_latency()` is the time taken to call a function, each call
+ * reaching its state through an address that depends on the value
+ * returned by the previous call, so that calls cannot overlap.
+ */
+static double time_latency(
+    fenv_call_fn fn,
+    struct fenv_state * s,
+    int64_t num_calls,
+    volatile int * sink)
+{
+    struct timespec t0, t1;
+    int zero = fenv_zero;
+    int x = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int64_t i = 0; i < num_calls; i++)
+        x = fn((struct fenv_state *) ((char *) s + (x & zero)));
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    *sink = x;
+    return timespec_duration(t0, t1);
+}
+
+/**
+ * `fenvbench_thread()` measures each function in the calling thread.
+ */
+static int fenvbench_thread(
+    int64_t num_calls,
+    int num_runs,
+    double * latency,
+    double * throughput)
+{
+    struct fenv_state s;
+    s.excepts = FE_ALL_EXCEPT;
+    s.round = fegetround();
+    if (fegetexceptflag(&s.flags, FE_ALL_EXCEPT) || fegetenv(&s.env))
+        return ENOTSUP;
+    volatile int sink;
+
+    double none_latency = 0, none_throughput = 0;
+    for (int run = 0; run < num_runs; run++) {
+        double t = time_latency(call_none, &s, num_calls, &sink);
+        if (run == 0 || none_latency > t)
+            none_latency = t;
+        t = time_throughput(call_none, &s, num_calls, &sink);
+        if (run == 0 || none_throughput > t)
+            none_throughput = t;
+    }
+
+    for (int c = 0; c < num_fenv_calls; c++) {
+        double best_latency = 0, best_throughput = 0;
+        for (int run = 0; run < num_runs; run++) {
+            double t = time_latency(fenv_call_fns[c], &s, num_calls, &sink);
+            if (run == 0 || best_latency > t)
+                best_latency = t;
+            t = time_throughput(fenv_call_fns[c], &s, num_calls, &sink);
+            if (run == 0 || best_throughput > t)
+                best_throughput = t;
+        }
+        latency[c] = (best_latency - none_latency) / num_calls;
+        throughput[c] = (best_throughput - none_throughput) / num_calls;
+        if (latency[c] < 0)
+            latency[c] = 0;
+        if (throughput[c] < 0)
+            throughput[c] = 0;
+    }
+    fesetenv(&s.env);
+    return 0;
+}
+
+/**
+ * `fenvbench()` measures the cost of floating-point environment
+ * functions in each of `num_threads` threads.
+ */
+int fenvbench(
+    int num_threads,
+    int64_t num_calls,
+    int num_runs,
+    struct fenvbench_result * result)
+{
+    if (num_threads <= 0 || num_calls <= 0 || num_runs <= 0)
+        return EINVAL;
+#ifndef _OPENMP
+    if (num_threads > 1)
+        return ENOTSUP;
+#endif
+    result->num_threads = num_threads;
+    for (int c = 0; c < num_fenv_calls; c++) {
+        result->latency[c] = 0;
+        result->throughput[c] = 0;
+    }
+
+    int err = 0;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        double latency[num_fenv_calls];
+        double throughput[num_fenv_calls];
+        #pragma omp barrier
+        int thread_err = fenvbench_thread(num_calls, num_runs, latency, throughput);
+        #pragma omp critical
+        {
+            if (thread_err)
+                err = thread_err;
+            for (int c = 0; !thread_err && c < num_fenv_calls; c++) {
+                if (result->latency[c] < latency[c])
+                    result->latency[c] = latency[c];
+                if (result->throughput[c] < throughput[c])
+                    result->throughput[c] = throughput[c];
+            }
+        }
+    }
+    return err;
+}
+
+/**
+ * `fenvbench_repetition_overhead()` is the time, in seconds, that
+ * each thread spends per repetition of `benchmark_mathop()` on
+ * clearing and testing floating-point exceptions.
+ */
+double fenvbench_repetition_overhead(
+    const struct fenvbench_result * result)
+{
+    if (!(math_errhandling & MATH_ERREXCEPT))
+        return 0.0;
+    return result->throughput[fenv_feclearexcept] +
+        result->throughput[fenv_fetestexcept];
+}
+
+/**
+ * `fenvbench_print()` prints the latency and reciprocal throughput of
+ * each floating-point environment function in nanoseconds.
+ */
+void fenvbench_print(
+    const struct fenvbench_result * result,
+    FILE * f)
+{
+    for (int c = 0; c < num_fenv_calls; c++) {
+        fprintf(f, "fenv-overhead: %d threads %s latency: %.2f ns "
+                "throughput: %.2f ns/call\n",
+                result->num_threads, fenv_call_str(c),
+                1e9 * result->latency[c], 1e9 * result->throughput[c]);
+    }
+}
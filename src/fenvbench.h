@@ -0,0 +1,104 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Microbenchmarks for the cost of floating-point environment calls.
+ */
+
+#ifndef FENVBENCH_H
+#define FENVBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `fenv_call` is used to enumerate the floating-point environment
+ * functions that are measured.
+ */
+enum fenv_call
+{
+    fenv_fegetround = 0,
+    fenv_fesetround,
+    fenv_feclearexcept,
+    fenv_fegetexceptflag,
+    fenv_fesetexceptflag,
+    fenv_fetestexcept,
+    fenv_fegetenv,
+    fenv_fesetenv,
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_fenv_calls
+};
+
+/**
+ * `fenv_call_str()` is a string representing a given floating-point
+ * environment function.
+ */
+const char * fenv_call_str(
+    enum fenv_call fenv_call);
+
+/**
+ * `fenvbench_result` contains the latency and the reciprocal
+ * throughput, in seconds per call, of each floating-point environment
+ * function when called by each of a given number of threads at once.
+ */
+struct fenvbench_result
+{
+    int num_threads;
+    double latency[num_fenv_calls];
+    double throughput[num_fenv_calls];
+};
+
+/**
+ * `fenvbench()` measures the cost of floating-point environment
+ * functions in each of `num_threads` threads.
+ *
+ * For the reciprocal throughput, each function is called `num_calls`
+ * times back-to-back. For the latency, the arguments of each call
+ * are read through an address that depends on the value returned by
+ * the previous call, so that a call cannot start before the previous
+ * one has returned its result. In both cases, the time taken to
+ * call an empty function in the same way is subtracted. The fastest
+ * of `num_runs` runs is used, and, for multiple threads, the slowest
+ * thread. The floating-point environment of each thread is restored
+ * afterwards.
+ */
+int fenvbench(
+    int num_threads,
+    int64_t num_calls,
+    int num_runs,
+    struct fenvbench_result * result);
+
+/**
+ * `fenvbench_repetition_overhead()` is the time, in seconds, that
+ * each thread spends per repetition of `benchmark_mathop()` on
+ * clearing and testing floating-point exceptions, which is zero if
+ * the math library does not report errors through exceptions.
+ */
+double fenvbench_repetition_overhead(
+    const struct fenvbench_result * result);
+
+/**
+ * `fenvbench_print()` prints the latency and reciprocal throughput of
+ * each floating-point environment function in nanoseconds.
+ */
+void fenvbench_print(
+    const struct fenvbench_result * result,
+    FILE * f);
+
+#endif
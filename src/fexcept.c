@@ -51,6 +51,90 @@ void fexcept_store(
     fegetexceptflag(fexcept, excepts);
 }
 
+/**
+ * `fexcept_excepts()` is the set of exceptions, as a bitwise OR of
+ * `FE_*` macros, that are stored in a `fexcept_t`.
+ */
+int fexcept_excepts(
+    fexcept_t fexcept)
+{
+    if (!(math_errhandling & MATH_ERREXCEPT))
+        return 0;
+    fexcept_t saved;
+    fegetexceptflag(&saved, FE_ALL_EXCEPT);
+    fesetexceptflag(&fexcept, FE_ALL_EXCEPT);
+    int excepts = fetestexcept(FE_ALL_EXCEPT);
+    fesetexceptflag(&saved, FE_ALL_EXCEPT);
+    return excepts;
+}
+
+/**
+ * `fexcept_set()` stores a set of exceptions, given as a bitwise OR
+ * of `FE_*` macros, in a `fexcept_t`.
+ */
+void fexcept_set(
+    fexcept_t * fexcept,
+    int excepts)
+{
+    if (!(math_errhandling & MATH_ERREXCEPT))
+        return;
+    fexcept_t saved;
+    fegetexceptflag(&saved, FE_ALL_EXCEPT);
+    feclearexcept(FE_ALL_EXCEPT);
+    feraiseexcept(excepts & FE_ALL_EXCEPT);
+    fegetexceptflag(fexcept, FE_ALL_EXCEPT);
+    fesetexceptflag(&saved, FE_ALL_EXCEPT);
+}
+
+/**
+ * `fexcept_excepts_str()` converts a set of exceptions, given as a
+ * bitwise OR of `FE_*` macros, to a string.
+ */
+const char * fexcept_excepts_str(
+    int excepts)
+{
+    static const char * strs[32] = {
+        "none",
+        "divide-by-zero",
+        "inexact",
+        "divide-by-zero,inexact",
+        "invalid",
+        "divide-by-zero,invalid",
+        "inexact,invalid",
+        "divide-by-zero,inexact,invalid",
+        "overflow",
+        "divide-by-zero,overflow",
+        "inexact,overflow",
+        "divide-by-zero,inexact,overflow",
+        "invalid,overflow",
+        "divide-by-zero,invalid,overflow",
+        "inexact,invalid,overflow",
+        "divide-by-zero,inexact,invalid,overflow",
+        "underflow",
+        "divide-by-zero,underflow",
+        "inexact,underflow",
+        "divide-by-zero,inexact,underflow",
+        "invalid,underflow",
+        "divide-by-zero,invalid,underflow",
+        "inexact,invalid,underflow",
+        "divide-by-zero,inexact,invalid,underflow",
+        "overflow,underflow",
+        "divide-by-zero,overflow,underflow",
+        "inexact,overflow,underflow",
+        "divide-by-zero,inexact,overflow,underflow",
+        "invalid,overflow,underflow",
+        "divide-by-zero,invalid,overflow,underflow",
+        "inexact,invalid,overflow,underflow",
+        "divide-by-zero,inexact,invalid,overflow,underflow",
+    };
+    int i = ((excepts & FE_DIVBYZERO) ? 1 : 0) |
+        ((excepts & FE_INEXACT) ? 2 : 0) |
+        ((excepts & FE_INVALID) ? 4 : 0) |
+        ((excepts & FE_OVERFLOW) ? 8 : 0) |
+        ((excepts & FE_UNDERFLOW) ? 16 : 0);
+    return strs[i];
+}
+
 /**
  * `fexcept_str()` converts floating-point exceptions to a string.
  */
@@ -59,69 +143,7 @@ const char * fexcept_str(
 {
     if (!(math_errhandling & MATH_ERREXCEPT))
         return "disabled";
-
-    fesetexceptflag(&fexcept, FE_ALL_EXCEPT);
-    if (fetestexcept(FE_DIVBYZERO)) {
-        return "divide-by-zero";
-    } else if (fetestexcept(FE_INEXACT)) {
-        return "inexact";
-    } else if (fetestexcept(FE_INVALID)) {
-        return "invalid";
-    } else if (fetestexcept(FE_OVERFLOW)) {
-        return "overflow";
-    } else if (fetestexcept(FE_UNDERFLOW)) {
-        return "underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT)) {
-        return "divide-by-zero,inexact";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INVALID)) {
-        return "divide-by-zero,invalid";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_OVERFLOW)) {
-        return "divide-by-zero,overflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_UNDERFLOW)) {
-        return "divide-by-zero,underflow";
-    } else if (fetestexcept(FE_INEXACT | FE_INVALID)) {
-        return "inexact,invalid";
-    } else if (fetestexcept(FE_INEXACT | FE_OVERFLOW)) {
-        return "inexact,overflow";
-    } else if (fetestexcept(FE_INEXACT | FE_UNDERFLOW)) {
-        return "inexact,underflow";
-    } else if (fetestexcept(FE_INVALID | FE_OVERFLOW)) {
-        return "invalid,overflow";
-    } else if (fetestexcept(FE_INVALID | FE_UNDERFLOW)) {
-        return "invalid,underflow";
-    } else if (fetestexcept(FE_OVERFLOW | FE_UNDERFLOW)) {
-        return "overflow,underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT | FE_INVALID)) {
-        return "divide-by-zero,inexact,invalid";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT | FE_OVERFLOW)) {
-        return "divide-by-zero,inexact,overflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT | FE_UNDERFLOW)) {
-        return "divide-by-zero,inexact,underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW)) {
-        return "divide-by-zero,invalid,overflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_UNDERFLOW)) {
-        return "divide-by-zero,invalid,underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_OVERFLOW | FE_UNDERFLOW)) {
-        return "divide-by-zero,overflow,underflow";
-    } else if (fetestexcept(FE_INEXACT | FE_INVALID | FE_OVERFLOW)) {
-        return "inexact,invalid,overflow";
-    } else if (fetestexcept(FE_INEXACT | FE_INVALID | FE_UNDERFLOW)) {
-        return "inexact,invalid,underflow";
-    } else if (fetestexcept(FE_INEXACT | FE_OVERFLOW | FE_UNDERFLOW)) {
-        return "inexact,overflow,underflow";
-    } else if (fetestexcept(FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW)) {
-        return "invalid,overflow,underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT | FE_INVALID | FE_OVERFLOW)) {
-        return "divide-by-zero,inexact,invalid,overflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT | FE_INVALID | FE_UNDERFLOW)) {
-        return "divide-by-zero,inexact,invalid,underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW)) {
-        return "divide-by-zero,invalid,overflow,underflow";
-    } else if (fetestexcept(FE_DIVBYZERO | FE_INEXACT | FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW)) {
-        return "divide-by-zero,inexact,invalid,overflow,underflow";
-    } else {
-        return "none";
-    }
+    return fexcept_excepts_str(fexcept_excepts(fexcept));
 }
 
 /**
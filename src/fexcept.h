@@ -43,6 +43,31 @@ void fexcept_store(
     fexcept_t * fexcept,
     int excepts);
 
+/**
+ * `fexcept_excepts()` is the set of exceptions, as a bitwise OR of
+ * `FE_*` macros, that are stored in a `fexcept_t`.
+ */
+int fexcept_excepts(
+    fexcept_t fexcept);
+
+/**
+ * `fexcept_set()` stores a set of exceptions, given as a bitwise OR
+ * of `FE_*` macros, in a `fexcept_t`.
+ *
+ * The exception flags of the calling thread are left unchanged.
+ */
+void fexcept_set(
+    fexcept_t * fexcept,
+    int excepts);
+
+/**
+ * `fexcept_excepts_str()` converts a set of exceptions, given as a
+ * bitwise OR of `FE_*` macros, to a comma-separated list, such as
+ * `invalid,overflow'.
+ */
+const char * fexcept_excepts_str(
+    int excepts);
+
 /**
  * `fexcept_str()` converts floating-point exceptions to a string.
  */
@@ -0,0 +1,121 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Kernels of independent vector fused multiply-adds.
+ */
+
+#include "fma.h"
+
+#include <stdint.h>
+
+/*
+ * Kernels of independent vector fused multiply-adds with enough
+ * accumulators to keep all FMA units busy. Each iteration performs
+ * `2 * FMA_ACCUMULATORS * WIDTH` floating-point operations. The
+ * kernels for wider vectors are compiled for the corresponding
+ * instruction set extensions and selected at run time.
+ */
+
+#define FMA_ACCUMULATORS 12
+
+#define fma_kernel_fn(NAME, TARGET, WIDTH)                              \
+    TARGET static double NAME(                                          \
+        int64_t iterations)                                             \
+    {                                                                   \
+        typedef double vec __attribute__((vector_size(WIDTH*8)));       \
+        vec acc[FMA_ACCUMULATORS];                                      \
+        vec b, c;                                                       \
+        for (int k = 0; k < WIDTH; k++) {                               \
+            b[k] = 0.999999;                                            \
+            c[k] = 1e-6;                                                \
+        }                                                               \
+        for (int j = 0; j < FMA_ACCUMULATORS; j++)                      \
+            acc[j] = b * (double) j;                                    \
+        for (int64_t i = 0; i < iterations; i++) {                      \
+            _Pragma("GCC unroll 12")                                    \
+            for (int j = 0; j < FMA_ACCUMULATORS; j++)                  \
+                acc[j] = acc[j] * b + c;                                \
+        }                                                               \
+        double sum = 0.0;                                               \
+        for (int j = 0; j < FMA_ACCUMULATORS; j++) {                    \
+            for (int k = 0; k < WIDTH; k++)                             \
+                sum += acc[j][k];                                       \
+        }                                                               \
+        return sum;                                                     \
+    }
+
+fma_kernel_fn(fma_kernel_generic, , 2)
+#if defined(__x86_64__) || defined(__i386__)
+fma_kernel_fn(fma_kernel_avx2, __attribute__((target("avx2,fma"))), 4)
+fma_kernel_fn(fma_kernel_avx512, __attribute__((target("avx512f"))), 8)
+#endif
+
+/**
+ * `fma_width()` is the number of doubles in the vectors used by the
+ * widest FMA kernel that is supported by the CPU.
+ */
+static int fma_width(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f"))
+        return 8;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return 4;
+#endif
+    return 2;
+}
+
+/**
+ * `fma_kernel_name()` is the name of the widest FMA kernel that is
+ * supported by the CPU.
+ */
+const char * fma_kernel_name(void)
+{
+    switch (fma_width()) {
+    case 8: return "avx512f";
+    case 4: return "avx2";
+    default: return "generic";
+    }
+}
+
+/**
+ * `fma_flops_per_iteration()` is the number of floating-point
+ * operations performed by each iteration of `fma_kernel()`.
+ */
+int64_t fma_flops_per_iteration(void)
+{
+    return 2 * FMA_ACCUMULATORS * fma_width();
+}
+
+/**
+ * `fma_kernel()` performs the given number of iterations of
+ * independent vector fused multiply-adds.
+ */
+double fma_kernel(
+    int64_t iterations)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (fma_width()) {
+    case 8: return fma_kernel_avx512(iterations);
+    case 4: return fma_kernel_avx2(iterations);
+    default: break;
+    }
+#endif
+    return fma_kernel_generic(iterations);
+}
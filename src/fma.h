@@ -0,0 +1,53 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Kernels of independent vector fused multiply-adds.
+ */
+
+#ifndef FMA_H
+#define FMA_H
+
+#include <stdint.h>
+
+/**
+ * `fma_kernel_name()` is the name of the widest FMA kernel that is
+ * supported by the CPU: `avx512f', `avx2' or `generic'.
+ */
+const char * fma_kernel_name(void);
+
+/**
+ * `fma_flops_per_iteration()` is the number of floating-point
+ * operations performed by each iteration of `fma_kernel()`.
+ */
+int64_t fma_flops_per_iteration(void);
+
+/**
+ * `fma_kernel()` performs the given number of iterations of
+ * independent vector fused multiply-adds, using the widest vectors
+ * supported by the CPU.
+ *
+ * Enough independent accumulators are used to keep every FMA unit
+ * busy, so that the kernel runs close to the peak floating-point rate
+ * of a core. The returned sum of the accumulators should be consumed
+ * by the caller to keep the compiler from removing the kernel.
+ */
+double fma_kernel(
+    int64_t iterations);
+
+#endif
@@ -0,0 +1,304 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Classification of results that explain floating-point exceptions.
+ */
+
+#include "fpclass.h"
+#include "fexcept.h"
+#include "mathop.h"
+
+#include <errno.h>
+
+#include <fenv.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * `exceptions_mode_str()` is a string representing a given way of
+ * reporting floating-point exceptions.
+ */
+const char * exceptions_mode_str(
+    enum exceptions_mode exceptions_mode)
+{
+    switch (exceptions_mode) {
+    case exceptions_summary: return "summary";
+    case exceptions_detail: return "detail";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `parse_exceptions_mode()` parses a string designating a way of
+ * reporting floating-point exceptions.
+ */
+int parse_exceptions_mode(
+    const char * s,
+    enum exceptions_mode * exceptions_mode)
+{
+    if (strcmp(s, "summary") == 0) {
+        *exceptions_mode = exceptions_summary;
+    } else if (strcmp(s, "detail") == 0) {
+        *exceptions_mode = exceptions_detail;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `fpclass_str()` is a string describing a class of results.
+ */
+const char * fpclass_str(
+    enum fpclass fpclass)
+{
+    switch (fpclass) {
+    case fpclass_nan: return "NaN results from non-NaN inputs";
+    case fpclass_inf: return "infinite results from finite inputs";
+    case fpclass_subnormal: return "subnormal results";
+    case fpclass_zero: return "zero results from non-zero inputs";
+    default: return "unknown";
+    }
+}
+
+/*
+ * The absolute value of a floating-point number, as an integer, is
+ * greater than the bit pattern of infinity for NaN, equal to it for
+ * infinity, and less than the smallest normal number for zero and
+ * subnormal numbers.
+ */
+#define F64_ABS 0x7fffffffffffffffull
+#define F64_INF 0x7ff0000000000000ull
+#define F64_MIN_NORMAL 0x0010000000000000ull
+#define F32_ABS 0x7fffffffu
+#define F32_INF 0x7f800000u
+#define F32_MIN_NORMAL 0x00800000u
+
+/**
+ * `fpclass_f64()` is the class of a double precision result, or
+ * `num_fpclasses` if the result is in none of the classes.
+ */
+static inline int fpclass_f64(
+    double x,
+    double y)
+{
+    uint64_t a, b;
+    memcpy(&a, &x, sizeof(a));
+    memcpy(&b, &y, sizeof(b));
+    a &= F64_ABS;
+    b &= F64_ABS;
+    if (b > F64_INF && a <= F64_INF)
+        return fpclass_nan;
+    if (b == F64_INF && a < F64_INF)
+        return fpclass_inf;
+    if (b != 0 && b < F64_MIN_NORMAL)
+        return fpclass_subnormal;
+    if (b == 0 && a != 0)
+        return fpclass_zero;
+    return num_fpclasses;
+}
+
+/**
+ * `fpclass_f32()` is the class of a single precision result, or
+ * `num_fpclasses` if the result is in none of the classes.
+ */
+static inline int fpclass_f32(
+    float x,
+    float y)
+{
+    uint32_t a, b;
+    memcpy(&a, &x, sizeof(a));
+    memcpy(&b, &y, sizeof(b));
+    a &= F32_ABS;
+    b &= F32_ABS;
+    if (b > F32_INF && a <= F32_INF)
+        return fpclass_nan;
+    if (b == F32_INF && a < F32_INF)
+        return fpclass_inf;
+    if (b != 0 && b < F32_MIN_NORMAL)
+        return fpclass_subnormal;
+    if (b == 0 && a != 0)
+        return fpclass_zero;
+    return num_fpclasses;
+}
+
+/**
+ * `fpclass_count_f64()` counts the double precision results in each
+ * class.
+ */
+static void fpclass_count_f64(
+    int64_t size,
+    const double * restrict x,
+    const double * restrict y,
+    int64_t * counts)
+{
+    int64_t nan = 0, inf = 0, subnormal = 0, zero = 0;
+    #pragma omp parallel for simd schedule(static) \
+        reduction(+:nan,inf,subnormal,zero)
+    for (int64_t i = 0; i < size; i++) {
+        uint64_t a, b;
+        memcpy(&a, &x[i], sizeof(a));
+        memcpy(&b, &y[i], sizeof(b));
+        a &= F64_ABS;
+        b &= F64_ABS;
+        nan += (b > F64_INF) & (a <= F64_INF);
+        inf += (b == F64_INF) & (a < F64_INF);
+        subnormal += (b != 0) & (b < F64_MIN_NORMAL);
+        zero += (b == 0) & (a != 0);
+    }
+    counts[fpclass_nan] = nan;
+    counts[fpclass_inf] = inf;
+    counts[fpclass_subnormal] = subnormal;
+    counts[fpclass_zero] = zero;
+}
+
+/**
+ * `fpclass_count_f32()` counts the single precision results in each
+ * class.
+ */
+static void fpclass_count_f32(
+    int64_t size,
+    const float * restrict x,
+    const float * restrict y,
+    int64_t * counts)
+{
+    int64_t nan = 0, inf = 0, subnormal = 0, zero = 0;
+    #pragma omp parallel for simd schedule(static) \
+        reduction(+:nan,inf,subnormal,zero)
+    for (int64_t i = 0; i < size; i++) {
+        uint32_t a, b;
+        memcpy(&a, &x[i], sizeof(a));
+        memcpy(&b, &y[i], sizeof(b));
+        a &= F32_ABS;
+        b &= F32_ABS;
+        nan += (b > F32_INF) & (a <= F32_INF);
+        inf += (b == F32_INF) & (a < F32_INF);
+        subnormal += (b != 0) & (b < F32_MIN_NORMAL);
+        zero += (b == 0) & (a != 0);
+    }
+    counts[fpclass_nan] = nan;
+    counts[fpclass_inf] = inf;
+    counts[fpclass_subnormal] = subnormal;
+    counts[fpclass_zero] = zero;
+}
+
+/**
+ * `fpclass_classify()` classifies every input and result of a math
+ * operation.
+ */
+int fpclass_classify(
+    const struct mathop_input * input,
+    const struct mathop_result * result,
+    struct fpclass_counts * counts)
+{
+    if (input->size != result->size)
+        return EINVAL;
+    int64_t size = result->size;
+    bool f64;
+    if (input->type == mathop_input_f64 && result->type == mathop_result_f64) {
+        f64 = true;
+        fpclass_count_f64(size, input->f64, result->f64, counts->counts);
+    } else if (input->type == mathop_input_f32 && result->type == mathop_result_f32) {
+        f64 = false;
+        fpclass_count_f32(size, input->f32, result->f32, counts->counts);
+    } else {
+        return EINVAL;
+    }
+
+    /* Find the first elements of each class that occurs. */
+    for (int c = 0; c < num_fpclasses; c++) {
+        counts->num_indices[c] = 0;
+        int64_t max_indices = counts->counts[c] < FPCLASS_MAX_INDICES
+            ? counts->counts[c] : FPCLASS_MAX_INDICES;
+        for (int64_t i = 0; i < size && counts->num_indices[c] < max_indices; i++) {
+            int d = f64
+                ? fpclass_f64(input->f64[i], result->f64[i])
+                : fpclass_f32(input->f32[i], result->f32[i]);
+            if (d == c)
+                counts->indices[c][counts->num_indices[c]++] = i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * `fpclass_print_class()` prints the count of a class of results and
+ * the indices of its first elements.
+ */
+static void fpclass_print_class(
+    const struct fpclass_counts * counts,
+    enum fpclass c,
+    FILE * f)
+{
+    fprintf(f, "%"PRId64" %s", counts->counts[c], fpclass_str(c));
+    for (int i = 0; i < counts->num_indices[c]; i++)
+        fprintf(f, i == 0 ? " at %"PRId64 : ", %"PRId64, counts->indices[c][i]);
+    if (counts->counts[c] > counts->num_indices[c])
+        fprintf(f, ", ...");
+}
+
+/**
+ * `fpclass_print()` prints, for each of the given floating-point
+ * exceptions, the classes of results that explain it.
+ */
+void fpclass_print(
+    const struct fpclass_counts * counts,
+    int excepts,
+    bool all,
+    const char * prefix,
+    FILE * f)
+{
+    static const struct {
+        int except;
+        const char * name;
+        enum fpclass classes[2];
+        int num_classes;
+    } flags[] = {
+        {FE_DIVBYZERO, "divide-by-zero", {fpclass_inf}, 1},
+        {FE_INVALID, "invalid", {fpclass_nan}, 1},
+        {FE_OVERFLOW, "overflow", {fpclass_inf}, 1},
+        {FE_UNDERFLOW, "underflow", {fpclass_subnormal, fpclass_zero}, 2},
+    };
+
+    if (all) {
+        for (int c = 0; c < num_fpclasses; c++) {
+            if (!counts->counts[c])
+                continue;
+            fprintf(f, "%s", prefix);
+            fpclass_print_class(counts, c, f);
+            fputc('\n', f);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(flags) / sizeof(*flags); i++) {
+        if (!(excepts & flags[i].except))
+            continue;
+        fprintf(f, "%s%s: ", prefix, flags[i].name);
+        for (int j = 0; j < flags[i].num_classes; j++) {
+            if (j > 0)
+                fprintf(f, "; ");
+            fpclass_print_class(counts, flags[i].classes[j], f);
+        }
+        fputc('\n', f);
+    }
+}
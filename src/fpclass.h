@@ -0,0 +1,131 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Classification of results that explain floating-point exceptions.
+ */
+
+#ifndef FPCLASS_H
+#define FPCLASS_H
+
+#include "mathop.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* The number of element indices recorded for each class. */
+#define FPCLASS_MAX_INDICES 5
+
+/**
+ * `exceptions_mode` is used to enumerate how floating-point exceptions
+ * are reported.
+ */
+enum exceptions_mode
+{
+    exceptions_summary = 0, /* exceptions raised by each thread */
+    exceptions_detail,      /* also classify every input and result */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_exceptions_modes
+};
+
+/**
+ * `exceptions_mode_str()` is a string representing a given way of
+ * reporting floating-point exceptions.
+ */
+const char * exceptions_mode_str(
+    enum exceptions_mode exceptions_mode);
+
+/**
+ * `parse_exceptions_mode()` parses a string designating a way of
+ * reporting floating-point exceptions.
+ *
+ * On success, `parse_exceptions_mode()` returns `0`. If the string
+ * does not correspond to a valid mode, then `parse_exceptions_mode()`
+ * returns `EINVAL`.
+ */
+int parse_exceptions_mode(
+    const char * s,
+    enum exceptions_mode * exceptions_mode);
+
+/**
+ * `fpclass` is used to enumerate classes of results that indicate
+ * floating-point exceptions.
+ */
+enum fpclass
+{
+    fpclass_nan = 0,   /* NaN result from a non-NaN input (invalid) */
+    fpclass_inf,       /* infinite result from a finite input
+                        * (overflow or divide-by-zero) */
+    fpclass_subnormal, /* subnormal result (underflow) */
+    fpclass_zero,      /* zero result from a non-zero input (underflow) */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_fpclasses
+};
+
+/**
+ * `fpclass_str()` is a string describing a class of results.
+ */
+const char * fpclass_str(
+    enum fpclass fpclass);
+
+/**
+ * `fpclass_counts` is the number of results in each class, and the
+ * indices of the first results in each class.
+ */
+struct fpclass_counts
+{
+    int64_t counts[num_fpclasses];
+    int num_indices[num_fpclasses];
+    int64_t indices[num_fpclasses][FPCLASS_MAX_INDICES];
+};
+
+/**
+ * `fpclass_classify()` classifies every input and result of a math
+ * operation.
+ *
+ * The classes are counted in parallel with vectorised integer
+ * compares on the bit patterns of the values. Then, for each class
+ * that occurs, the first `FPCLASS_MAX_INDICES` elements in the class
+ * are found by a sequential search, which stops as soon as they are
+ * found.
+ */
+int fpclass_classify(
+    const struct mathop_input * input,
+    const struct mathop_result * result,
+    struct fpclass_counts * counts);
+
+/**
+ * `fpclass_print()` prints, for each of the given floating-point
+ * exceptions, the classes of results that explain it, together with
+ * their counts and the indices of the first elements in each class.
+ *
+ * If `all` is true, for example because exceptions are not supported,
+ * then every class that occurs is printed regardless of `excepts`.
+ * Each line begins with `prefix`.
+ */
+void fpclass_print(
+    const struct fpclass_counts * counts,
+    int excepts,
+    bool all,
+    const char * prefix,
+    FILE * f);
+
+#endif
@@ -0,0 +1,456 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Interval evaluation of math operations using directed rounding.
+ */
+
+#include "interval.h"
+#include "fexcept.h"
+#include "mathop.h"
+#include "round.h"
+
+#ifdef HAVE_MPFR
+#include <mpfr.h>
+#endif
+
+#include <errno.h>
+
+#include <fenv.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `interval_block()` evaluates one block of `n` elements, starting at
+ * element `b`, through views of the input and result.
+ *
+ * The views share the thread states of the result, so that the
+ * exceptions and errno raised by each thread are recorded as in the
+ * benchmark itself. Domain and range errors are recorded there and do
+ * not stop the evaluation.
+ */
+static int interval_block(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    const struct mathop_result * result,
+    int64_t b,
+    int64_t n,
+    int64_t * num_ops)
+{
+    struct mathop_input x = *input;
+    x.size = n;
+    x.f32 = input->f32 ? input->f32 + b : NULL;
+    x.f64 = input->f64 ? input->f64 + b : NULL;
+    struct mathop_result y = *result;
+    y.size = n;
+    y.f32 = result->f32 ? result->f32 + b : NULL;
+    y.f64 = result->f64 ? result->f64 + b : NULL;
+    int err = benchmark_mathop(mathop, &x, &y, num_ops);
+    return err == EDOM || err == ERANGE ? 0 : err;
+}
+
+/**
+ * `interval_exceptions()` combines the exceptions and error numbers
+ * recorded by the threads that evaluated one of the bounds.
+ */
+static void interval_exceptions(
+    const struct mathop_result * result,
+    int * excepts,
+    int * errnum)
+{
+    *excepts = 0;
+    *errnum = 0;
+    for (int i = 0; i < result->num_threads; i++) {
+        *excepts |= result->threads[i].excepts;
+        if (!*errnum)
+            *errnum = result->threads[i].errnum;
+    }
+}
+
+/**
+ * `interval_pass()` evaluates the lower and upper bounds of every
+ * input element once, block by block.
+ *
+ * If `per_block` is true, the rounding mode is switched twice per
+ * block. Otherwise, it is switched once before all lower bounds and
+ * once before all upper bounds, so that the difference between the
+ * two is the cost of switching per block. Each block is evaluated by
+ * the kernels of `benchmark_mathop()`, so the blocks are shared among
+ * the threads of the parallel region in the same way as the benchmark
+ * itself. Errors do not stop the pass early, since every thread must
+ * reach the same worksharing loops.
+ */
+static int interval_pass(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    const struct mathop_result * lo,
+    const struct mathop_result * hi,
+    int64_t block_size,
+    bool per_block,
+    int64_t * num_ops)
+{
+    int err = 0;
+    #pragma omp parallel
+    {
+        int round = fegetround();
+        int thread_err = 0;
+        int64_t thread_ops = 0;
+        if (per_block) {
+            for (int64_t b = 0; b < input->size; b += block_size) {
+                int64_t n = input->size - b < block_size ? input->size - b : block_size;
+                set_round_mode(round_downward);
+                int e = interval_block(mathop, input, lo, b, n, &thread_ops);
+                if (e && !thread_err)
+                    thread_err = e;
+                set_round_mode(round_upward);
+                e = interval_block(mathop, input, hi, b, n, &thread_ops);
+                if (e && !thread_err)
+                    thread_err = e;
+            }
+        } else {
+            set_round_mode(round_downward);
+            for (int64_t b = 0; b < input->size; b += block_size) {
+                int64_t n = input->size - b < block_size ? input->size - b : block_size;
+                int e = interval_block(mathop, input, lo, b, n, &thread_ops);
+                if (e && !thread_err)
+                    thread_err = e;
+            }
+            set_round_mode(round_upward);
+            for (int64_t b = 0; b < input->size; b += block_size) {
+                int64_t n = input->size - b < block_size ? input->size - b : block_size;
+                int e = interval_block(mathop, input, hi, b, n, &thread_ops);
+                if (e && !thread_err)
+                    thread_err = e;
+            }
+        }
+        fesetround(round);
+        #pragma omp critical
+        {
+            if (thread_err && !err)
+                err = thread_err;
+        }
+        #pragma omp master
+        *num_ops += thread_ops;
+    }
+    return err;
+}
+
+#ifdef HAVE_MPFR
+/*
+ * MPFR functions with the same signature as `mpfr_exp()`.
+ */
+typedef int (* interval_mpfr_fn)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t);
+
+/**
+ * `mpfr_lgamma_abs()` computes the logarithm of the absolute value
+ * of the gamma function, discarding the sign.
+ */
+static int mpfr_lgamma_abs(
+    mpfr_ptr y,
+    mpfr_srcptr x,
+    mpfr_rnd_t rnd)
+{
+    int sign;
+    return mpfr_lgamma(y, &sign, x, rnd);
+}
+
+/**
+ * `interval_mpfr()` is the MPFR function corresponding to a math
+ * operation.
+ */
+static interval_mpfr_fn interval_mpfr(
+    enum mathop mathop)
+{
+    switch (mathop) {
+    case mathop_cos: case mathop_cosf: return mpfr_cos;
+    case mathop_sin: case mathop_sinf: return mpfr_sin;
+    case mathop_tan: case mathop_tanf: return mpfr_tan;
+    case mathop_acos: case mathop_acosf: return mpfr_acos;
+    case mathop_asin: case mathop_asinf: return mpfr_asin;
+    case mathop_atan: case mathop_atanf: return mpfr_atan;
+    case mathop_cosh: case mathop_coshf: return mpfr_cosh;
+    case mathop_sinh: case mathop_sinhf: return mpfr_sinh;
+    case mathop_tanh: case mathop_tanhf: return mpfr_tanh;
+    case mathop_acosh: case mathop_acoshf: return mpfr_acosh;
+    case mathop_asinh: case mathop_asinhf: return mpfr_asinh;
+    case mathop_atanh: case mathop_atanhf: return mpfr_atanh;
+    case mathop_exp: case mathop_expf: return mpfr_exp;
+    case mathop_log: case mathop_logf: return mpfr_log;
+    case mathop_log10: case mathop_log10f: return mpfr_log10;
+    case mathop_exp2: case mathop_exp2f: return mpfr_exp2;
+    case mathop_expm1: case mathop_expm1f: return mpfr_expm1;
+    case mathop_log1p: case mathop_log1pf: return mpfr_log1p;
+    case mathop_log2: case mathop_log2f: return mpfr_log2;
+    case mathop_sqrt: case mathop_sqrtf: return mpfr_sqrt;
+    case mathop_cbrt: case mathop_cbrtf: return mpfr_cbrt;
+    case mathop_erf: case mathop_erff: return mpfr_erf;
+    case mathop_erfc: case mathop_erfcf: return mpfr_erfc;
+    case mathop_tgamma: case mathop_tgammaf: return mpfr_gamma;
+    case mathop_lgamma: case mathop_lgammaf: return mpfr_lgamma_abs;
+    default: return NULL;
+    }
+}
+#endif
+
+/**
+ * `interval_check()` checks that every interval is non-empty and, if
+ * support for MPFR is enabled, that it contains the exact result,
+ * computed with `precision` bits and rounded to nearest.
+ */
+static int interval_check(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    const struct mathop_result * lo,
+    const struct mathop_result * hi,
+    int precision,
+    struct interval_result * result)
+{
+    result->num_inverted = 0;
+    result->num_nan = 0;
+    result->reference = false;
+    result->num_outside = 0;
+    result->first_outside = -1;
+
+#ifdef HAVE_MPFR
+    interval_mpfr_fn fn = interval_mpfr(mathop);
+    if (!fn)
+        return EINVAL;
+    mpfr_t x, y;
+    mpfr_init2(x, precision);
+    mpfr_init2(y, precision);
+    result->reference = true;
+#endif
+
+    for (int64_t i = 0; i < input->size; i++) {
+        double a = lo->type == mathop_result_f32 ? lo->f32[i] : lo->f64[i];
+        double b = hi->type == mathop_result_f32 ? hi->f32[i] : hi->f64[i];
+        if (isnan(a) || isnan(b))
+            result->num_nan++;
+        else if (a > b)
+            result->num_inverted++;
+
+#ifdef HAVE_MPFR
+        if (input->type == mathop_input_f32)
+            mpfr_set_flt(x, input->f32[i], MPFR_RNDN);
+        else
+            mpfr_set_d(x, input->f64[i], MPFR_RNDN);
+        fn(y, x, MPFR_RNDN);
+        bool inside = mpfr_nan_p(y)
+            ? isnan(a) && isnan(b)
+            : !isnan(a) && !isnan(b) &&
+              mpfr_cmp_d(y, a) >= 0 && mpfr_cmp_d(y, b) <= 0;
+        if (!inside) {
+            if (result->num_outside == 0)
+                result->first_outside = i;
+            result->num_outside++;
+        }
+#endif
+    }
+
+#ifdef HAVE_MPFR
+    mpfr_clears(x, y, (mpfr_ptr) 0);
+#endif
+    return 0;
+}
+
+/**
+ * `compare_doubles()` orders numbers in increasing order.
+ */
+static int compare_doubles(
+    const void * a,
+    const void * b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return x < y ? -1 : (x > y);
+}
+
+/**
+ * `quantile()` is the `q`-quantile of `n` sorted numbers, obtained by
+ * linear interpolation between the nearest ranks.
+ */
+static double quantile(
+    int n,
+    const double * x,
+    double q)
+{
+    double r = q * (n - 1);
+    int i = (int) r;
+    if (i >= n - 1)
+        return x[n - 1];
+    return x[i] + (r - i) * (x[i+1] - x[i]);
+}
+
+/**
+ * `interval_benchmark()` evaluates a math operation twice for every
+ * input element, under downward and under upward rounding, in
+ * `repeat` passes over the input.
+ */
+int interval_benchmark(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    int alignment,
+    int64_t block_size,
+    int repeat,
+    int precision,
+    struct interval_result * result)
+{
+    if (block_size <= 0)
+        return EINVAL;
+    if (repeat < 1)
+        repeat = 1;
+
+    struct mathop_result lo, hi;
+    int err = mathop_result_init(&lo, mathop, input->size, alignment);
+    if (err)
+        return err;
+    err = mathop_result_init(&hi, mathop, input->size, alignment);
+    if (err) {
+        mathop_result_free(&lo);
+        return err;
+    }
+
+    /* Warm up caches before the measurement. */
+    int64_t num_ops = 0;
+    err = interval_pass(mathop, input, &lo, &hi, block_size, true, &num_ops);
+
+    /*
+     * Alternate passes that switch rounding modes per block with passes
+     * that switch only twice, so that both are equally affected by
+     * drift in clock frequency. The overhead of switching is estimated
+     * from the median difference between the passes of each pair,
+     * which is robust to passes that are disturbed by noise.
+     */
+    double * differences = malloc(repeat * sizeof(double));
+    if (!differences)
+        err = errno;
+    result->block_size = block_size;
+    result->repeat = repeat;
+    result->num_ops = 0;
+    result->seconds = 0;
+    result->best_pass = 0;
+    result->switch_overhead = 0;
+    result->switch_noise = 0;
+    int num_pairs = 0;
+    for (int i = 0; !err && i < repeat; i++) {
+        struct timespec t0, t1;
+        num_ops = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        err = interval_pass(mathop, input, &lo, &hi, block_size, false, &num_ops);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double t_without_switches = timespec_duration(t0, t1);
+        if (err)
+            break;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        err = interval_pass(mathop, input, &lo, &hi, block_size, true, &result->num_ops);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double t = timespec_duration(t0, t1);
+        result->seconds += t;
+        if (i == 0 || result->best_pass > t)
+            result->best_pass = t;
+        if (!err)
+            differences[num_pairs++] = t - t_without_switches;
+    }
+    int64_t num_blocks = (input->size + block_size - 1) / block_size;
+    result->num_switches = 2 * num_blocks - 2;
+
+    if (num_pairs > 0) {
+        qsort(differences, num_pairs, sizeof(double), compare_doubles);
+        result->switch_overhead = quantile(num_pairs, differences, 0.5);
+        result->switch_noise = 0.5 * (
+            quantile(num_pairs, differences, 0.75) -
+            quantile(num_pairs, differences, 0.25));
+        struct timespec resolution;
+        if (clock_getres(CLOCK_MONOTONIC, &resolution) == 0) {
+            double r = resolution.tv_sec + resolution.tv_nsec * 1e-9;
+            if (result->switch_noise < r)
+                result->switch_noise = r;
+        }
+    }
+    free(differences);
+
+    interval_exceptions(&lo, &result->lo_excepts, &result->lo_errnum);
+    interval_exceptions(&hi, &result->hi_excepts, &result->hi_errnum);
+    if (!err)
+        err = interval_check(mathop, input, &lo, &hi, precision, result);
+    mathop_result_free(&hi);
+    mathop_result_free(&lo);
+    return err;
+}
+
+/**
+ * `interval_print()` prints the throughput of interval evaluation,
+ * the overhead of switching rounding modes and whether the intervals
+ * enclose the reference results.
+ */
+void interval_print(
+    enum mathop mathop,
+    const struct interval_result * result,
+    FILE * f)
+{
+    int64_t num_intervals = result->num_ops / 2;
+    double overhead = result->switch_overhead;
+    fprintf(f, "interval: %s block %"PRId64": %.6f seconds %d repetitions "
+            "%.6f Mintervals/s %.6f Mops/s ",
+            mathop_str(mathop), result->block_size, result->seconds, result->repeat,
+            result->seconds > 0 ? (double) num_intervals / result->seconds / 1000000.0 : 0.0,
+            result->seconds > 0 ? (double) result->num_ops / result->seconds / 1000000.0 : 0.0);
+    if (result->num_switches <= 0 || overhead <= result->switch_noise) {
+        fprintf(f, "mode switching: below timer resolution\n");
+    } else {
+        fprintf(f, "mode switching: %.3f ns/switch (%.2f%% of time)\n",
+                1e9 * overhead / result->num_switches,
+                result->best_pass > 0 ? 100.0 * overhead / result->best_pass : 0.0);
+    }
+    fprintf(f, "interval: empty intervals: %"PRId64" NaN bounds: %"PRId64,
+            result->num_inverted, result->num_nan);
+    if (!result->reference) {
+        fprintf(f, " reference enclosed: unknown (MPFR disabled)\n");
+    } else if (result->num_outside == 0) {
+        fprintf(f, " reference enclosed: yes\n");
+    } else {
+        fprintf(f, " reference enclosed: no (%"PRId64" outside, first at element %"PRId64")\n",
+                result->num_outside, result->first_outside);
+    }
+    fprintf(f, "interval: exceptions: lower bounds: %s",
+            fexcept_excepts_str(result->lo_excepts));
+    if (result->lo_errnum)
+        fprintf(f, " errno: %s", strerror(result->lo_errnum));
+    fprintf(f, " upper bounds: %s", fexcept_excepts_str(result->hi_excepts));
+    if (result->hi_errnum)
+        fprintf(f, " errno: %s", strerror(result->hi_errnum));
+    fputc('\n', f);
+}
@@ -0,0 +1,107 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Interval evaluation of math operations using directed rounding.
+ */
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include "mathop.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `interval_result` is the outcome of evaluating a math operation
+ * under downward and upward rounding to obtain an enclosure,
+ * `[lo, hi]`, of each result.
+ */
+struct interval_result
+{
+    int64_t block_size;
+    int repeat;
+    int64_t num_ops;
+    int64_t num_switches;
+    double seconds;
+    double best_pass;
+    double switch_overhead;
+    double switch_noise;
+
+    int64_t num_inverted;
+    int64_t num_nan;
+
+    int lo_excepts;
+    int lo_errnum;
+    int hi_excepts;
+    int hi_errnum;
+
+    bool reference;
+    int64_t num_outside;
+    int64_t first_outside;
+};
+
+/**
+ * `interval_benchmark()` evaluates a math operation twice for every
+ * input element, under downward and under upward rounding, in
+ * `repeat` passes over the input.
+ *
+ * The input is divided into blocks of `block_size` elements. Each
+ * thread switches the rounding mode once before evaluating the lower
+ * bounds of a block and once before evaluating its upper bounds,
+ * rather than once per element, and the rounding mode of each thread
+ * is restored afterwards. The same passes are also timed with the
+ * rounding mode switched only once before all lower bounds and once
+ * before all upper bounds, so that the overhead of switching per block
+ * can be estimated from the difference. The two kinds of passes are
+ * paired, and `switch_overhead` is the median difference of a pair,
+ * in seconds, whereas `switch_noise` is half the interquartile range
+ * of the differences, or the resolution of the clock, if larger.
+ *
+ * The floating-point exceptions and the first error number raised
+ * while evaluating the lower and upper bounds are recorded in
+ * `lo_excepts`, `lo_errnum`, `hi_excepts` and `hi_errnum`. Domain and
+ * range errors do not stop the evaluation, since they yield bounds
+ * such as NaN or infinity, which are reported below.
+ *
+ * The resulting intervals are checked to be non-empty and, if
+ * support for MPFR is enabled, to contain a reference result computed
+ * with `precision` bits.
+ */
+int interval_benchmark(
+    enum mathop mathop,
+    const struct mathop_input * input,
+    int alignment,
+    int64_t block_size,
+    int repeat,
+    int precision,
+    struct interval_result * result);
+
+/**
+ * `interval_print()` prints the throughput of interval evaluation,
+ * the overhead of switching rounding modes and whether the intervals
+ * enclose the reference results.
+ */
+void interval_print(
+    enum mathop mathop,
+    const struct interval_result * result,
+    FILE * f);
+
+#endif
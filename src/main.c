@@ -21,11 +21,35 @@
  */
 
 #include "program_options.h"
+#include "affinity.h"
+#include "arena.h"
+#include "batch.h"
+#include "corun.h"
+#include "dispatch.h"
+#include "fenvbench.h"
 #include "fexcept.h"
+#include "fpclass.h"
+#include "interval.h"
+#include "monitor.h"
+#include "noise.h"
+#include "ompbench.h"
+#include "osnoise.h"
+#include "profile.h"
+#include "rapl.h"
+#include "resource_usage.h"
+#include "roofline.h"
+#include "rt.h"
+#include "stats.h"
+#include "topology.h"
+#include "trace.h"
 
 #include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -53,6 +77,38 @@ static double timespec_duration(
         (t1.tv_nsec - t0.tv_nsec) * 1e-9;
 }
 
+/**
+ * `interrupted` is the signal, `SIGINT' or `SIGTERM', that asked the
+ * benchmark to stop after the current repetition, or zero.
+ */
+static volatile sig_atomic_t interrupted = 0;
+
+/**
+ * `interrupt_handler()` records that the program was interrupted.
+ */
+static void interrupt_handler(
+    int signum)
+{
+    interrupted = signum;
+}
+
+/**
+ * `interrupt_install()` handles `SIGINT' and `SIGTERM' by stopping the
+ * benchmark after the current repetition. The handler is reset when
+ * it runs, so that a second signal terminates the program.
+ */
+static int interrupt_install(void)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = interrupt_handler;
+    sa.sa_flags = SA_RESETHAND;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGINT, &sa, NULL) || sigaction(SIGTERM, &sa, NULL))
+        return errno;
+    return 0;
+}
+
 /*
  * Custom OpenMP reduction operator for combining errors from
  * different threads.
@@ -62,6 +118,74 @@ static double timespec_duration(
     omp_out = omp_out ? omp_out : omp_in)                               \
     initializer (omp_priv=0)
 
+/**
+ * `benchmark()` repeatedly benchmarks a math operation, or a baseline
+ * kernel, in parallel until the requested number of repetitions and
+ * operations is reached, and measures the elapsed time.
+ */
+static int benchmark(
+    const struct program_options * args,
+    enum mathop mathop,
+    enum mathop_baseline baseline,
+    struct mathop_input * input,
+    struct mathop_result * result,
+    int * out_repeat,
+    int64_t * out_num_ops,
+    double * seconds)
+{
+    int err = 0;
+    struct timespec t0, t1;
+    int repeat = 0;
+    int64_t num_ops = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+#pragma omp parallel reduction(err_add:err) reduction(max:num_ops) reduction(max:repeat)
+    {
+        for (repeat = 0, num_ops = 0; (repeat < args->repeat) || (num_ops < args->min_ops); repeat++) {
+            if (baseline == mathop_baseline_none)
+                err = benchmark_mathop(mathop, input, result, &num_ops);
+            else
+                err = benchmark_mathop_baseline(baseline, input, result, &num_ops);
+            if (err == EINTR) {
+                err = 0;
+                repeat++;
+                break;
+            }
+            if (err)
+                break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    mathop_result_merge_exceptions(result);
+    *out_repeat = repeat;
+    *out_num_ops = num_ops;
+    *seconds = timespec_duration(t0, t1);
+    return err;
+}
+
+/**
+ * `exceptions_detail_print()` classifies every result to find the
+ * elements that raised each exception, and prints the classes. This
+ * is done after the measurement, and not timed. If the measurement
+ * stopped because `errno' was set, the results of the last repetition
+ * are complete, and they are classified in the same way.
+ */
+static void exceptions_detail_print(
+    const struct mathop_input * input,
+    const struct mathop_result * result,
+    FILE * f)
+{
+    struct fpclass_counts counts;
+    int err = fpclass_classify(input, result, &counts);
+    if (err) {
+        fprintf(stderr, "%s: exceptions: %s\n",
+                program_invocation_short_name, strerror(err));
+        return;
+    }
+    fpclass_print(
+        &counts, fexcept_excepts(result->fexcept),
+        !(math_errhandling & MATH_ERREXCEPT), "exceptions: ", f);
+}
+
 /**
  * `main()`.
  */
@@ -69,6 +193,7 @@ int main(int argc, char *argv[])
 {
     int err;
     struct timespec t0, t1;
+    double duration = 0.0;
 
     /* Parse program options. */
     struct program_options args;
@@ -94,6 +219,47 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    /*
+     * Replay calls recorded by the trace library instead of
+     * benchmarking a single math operation.
+     */
+    if (args.replay_path) {
+        struct trace trace;
+        err = trace_read(args.replay_path, &trace);
+        if (err) {
+            fprintf(stderr, "%s: %s: %s\n", program_invocation_short_name,
+                    args.replay_path, strerror(err));
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        struct trace_replay_result * replay_result =
+            malloc(sizeof(struct trace_replay_result));
+        if (!replay_result) {
+            fprintf(stderr, "%s: %s\n", program_invocation_short_name,
+                    strerror(errno));
+            trace_free(&trace);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        err = trace_replay(
+            &trace, args.alignment, args.repeat, args.rounding_mode,
+            args.error_precision, replay_result);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_short_name,
+                    strerror(err));
+            free(replay_result);
+            trace_free(&trace);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (args.verbose > 0)
+            trace_replay_print(&trace, replay_result, stdout);
+        free(replay_result);
+        trace_free(&trace);
+        program_options_free(&args);
+        return EXIT_SUCCESS;
+    }
+
     /* Allocate storage and read input for the benchmark. */
     FILE * f = stdin;
     if (args.filename) {
@@ -125,6 +291,268 @@ int main(int argc, char *argv[])
         program_options_free(&args);
         return EXIT_FAILURE;
     }
+    result.stop = &interrupted;
+
+    /*
+     * If requested, bind each thread to a CPU. This is done before
+     * input and results are placed in memory, so that pages are
+     * first touched by the threads that will later access them.
+     */
+    struct topology topology = {0};
+    int num_threads = affinity_max_threads();
+    int * bind_cpus = NULL;
+    int * observed_start = NULL;
+    int * observed_end = NULL;
+    if (args.bind.type != affinity_none) {
+        err = topology_init(&topology);
+        if (!err) {
+            bind_cpus = malloc(3 * num_threads * sizeof(int));
+            if (!bind_cpus)
+                err = errno;
+        }
+        if (!err) {
+            observed_start = &bind_cpus[num_threads];
+            observed_end = &bind_cpus[2*num_threads];
+            err = affinity_cpus(&args.bind, &topology, num_threads, bind_cpus);
+        }
+        if (!err)
+            err = affinity_bind(num_threads, bind_cpus);
+        if (err) {
+            fprintf(stderr, "%s: bind: %s\n", program_invocation_short_name,
+                    strerror(err));
+            topology_free(&topology);
+            free(bind_cpus);
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * If requested, move input and results to a single arena backed
+     * by huge pages. Input and results are placed in memory according
+     * to a NUMA policy, if one is given.
+     */
+    struct arena arena = {0};
+    if (args.hugepages != hugepages_none) {
+        size_t alignment = args.alignment > sysconf(_SC_PAGESIZE)
+            ? args.alignment : sysconf(_SC_PAGESIZE);
+        size_t input_size = input.size * mathop_input_type_size(input.type);
+        size_t result_size = result.size * mathop_result_type_size(result.type);
+        size_t arena_size = input_size + result_size + 4 * alignment;
+
+        /*
+         * The input and results of the operation compared with `--ab'
+         * are placed in the same arena. Its results have the same
+         * type as its input.
+         */
+        enum mathop_input_type ab_input_type;
+        if (args.ab && !mathop_input(args.ab_mathop, &ab_input_type)) {
+            arena_size += 2 * input.size * mathop_input_type_size(ab_input_type)
+                + 4 * alignment;
+        }
+        err = arena_init(
+            &arena, arena_size, args.hugepages,
+            args.prefault && args.numa != mempolicy_firsttouch);
+        if (!err)
+            err = mempolicy_bind(arena.base, arena.size, args.numa);
+        if (!err)
+            err = mathop_input_place(&input, args.alignment, args.numa, &arena);
+        if (!err)
+            err = mathop_result_place(&result, args.alignment, args.numa, &arena);
+        if (err) {
+            fprintf(stderr, "%s: %s pages: %s\n", program_invocation_short_name,
+                    hugepages_str(args.hugepages), strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    } else if (args.numa != mempolicy_default) {
+        err = mathop_input_place(&input, args.alignment, args.numa, NULL);
+        if (!err)
+            err = mathop_result_place(&result, args.alignment, args.numa, NULL);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_short_name, strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * Touch every page of the input and results before the benchmark,
+     * and, if requested, lock all memory to prevent it from being
+     * paged out.
+     */
+    if (args.prefault) {
+        err = mathop_input_prefault(&input);
+        if (!err)
+            err = mathop_result_prefault(&result);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_short_name, strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+    if (args.mlock) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+            fprintf(stderr, "%s: mlockall: %s\n",
+                    program_invocation_short_name, strerror(errno));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * If requested, find the RAPL energy counters. Energy is not
+     * reported if the counters are absent or cannot be read.
+     */
+    struct rapl rapl;
+    bool energy = false;
+    if (args.energy) {
+        err = rapl_init(&rapl);
+        if (err) {
+            fprintf(stderr, "%s: warning: energy counters not available: %s\n",
+                    program_invocation_short_name, strerror(err));
+        } else {
+            energy = true;
+        }
+        err = 0;
+    }
+
+    /*
+     * If requested, open the file for the time series of throughput,
+     * where `-' means standard output.
+     */
+    FILE * monitor_file = NULL;
+    if (args.monitor_path) {
+        monitor_file = strcmp(args.monitor_path, "-") == 0
+            ? stdout : fopen(args.monitor_path, "w");
+        if (!monitor_file) {
+            fprintf(stderr, "%s: %s: %s\n", program_invocation_short_name,
+                    args.monitor_path, strerror(errno));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * If requested, probe operating system noise on each CPU that is
+     * bound to a thread, or on every online CPU if threads are not
+     * bound. The end of each repetition is then timestamped, so that
+     * the variation between repetitions can be compared with the
+     * variation predicted by the probe.
+     */
+    struct osnoise_cpu * osnoise_probes = NULL;
+    int num_osnoise_probes = 0;
+    struct timespec * repetition_times = NULL;
+    int max_repetition_times = 0;
+    int num_repetition_times = 0;
+    if (args.osnoise) {
+        if (!bind_cpus)
+            err = topology_init(&topology);
+        int max_probes = bind_cpus ? num_threads : topology.num_cpus;
+        if (!err) {
+            max_repetition_times = (args.repeat > 1024 ? args.repeat : 1024) + 1;
+            osnoise_probes = malloc(max_probes * sizeof(struct osnoise_cpu));
+            repetition_times = malloc(
+                max_repetition_times * sizeof(struct timespec));
+            if (!osnoise_probes || !repetition_times)
+                err = errno;
+        }
+        for (int i = 0; !err && i < max_probes; i++) {
+            int cpu = bind_cpus ? bind_cpus[i] : topology.cpus[i].cpu;
+            bool probed = false;
+            for (int j = 0; j < num_osnoise_probes; j++) {
+                if (osnoise_probes[j].cpu == cpu)
+                    probed = true;
+            }
+            if (probed)
+                continue;
+            err = osnoise_probe(
+                cpu, 2000, 20e-6, &osnoise_probes[num_osnoise_probes]);
+            if (!err)
+                num_osnoise_probes++;
+        }
+        if (err) {
+            fprintf(stderr, "%s: osnoise: %s\n", program_invocation_short_name,
+                    strerror(err));
+            if (monitor_file && monitor_file != stdout)
+                fclose(monitor_file);
+            free(repetition_times);
+            free(osnoise_probes);
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * If requested, run the benchmark threads with real-time priority
+     * and isolate them from other work, as far as permitted.
+     */
+    struct rt rt;
+    if (args.rt) {
+        err = rt_enter(&rt, args.rt_priority, num_threads, bind_cpus);
+        if (err) {
+            fprintf(stderr, "%s: rt: %s\n", program_invocation_short_name,
+                    strerror(err));
+            if (monitor_file && monitor_file != stdout)
+                fclose(monitor_file);
+            free(repetition_times);
+            free(osnoise_probes);
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (!rt.fifo_err && rt_throttled(&rt)) {
+            fprintf(stderr, "%s: rt: warning: SCHED_FIFO threads may be throttled"
+                    " after %ld us of every %ld us (sched_rt_runtime_us)\n",
+                    program_invocation_short_name, rt.rt_runtime_us, rt.rt_period_us);
+        }
+    }
+
+    /*
+     * From here on, an interrupted benchmark stops after the current
+     * repetition and reports the repetitions completed so far.
+     */
+    err = interrupt_install();
+    if (err) {
+        fprintf(stderr, "%s: %s\n", program_invocation_short_name,
+                strerror(err));
+        err = 0;
+    }
 
     /* Start a timer. */
     if (args.verbose > 0) {
@@ -136,15 +564,132 @@ int main(int argc, char *argv[])
     /* Benchmark the mathematical function. */
     int repeat = 0;
     int64_t num_ops = 0;
-#pragma omp parallel reduction(err_add:err) reduction(max:num_ops) reduction(max:repeat)
-    for (repeat = 0, num_ops = 0; (repeat < args.repeat) || (num_ops < args.min_ops); repeat++) {
-        err = benchmark_mathop(args.mathop, &input, &result, &num_ops);
-        if (err)
-            break;
+    int64_t minor_faults = 0, major_faults = 0;
+    int64_t voluntary_context_switches = 0, involuntary_context_switches = 0;
+    struct profile profile;
+    bool profiling = false;
+    if (args.profile) {
+        err = profile_start(&profile, num_threads, 4000);
+        if (err) {
+            fprintf(stderr, "%s: profile: %s\n", program_invocation_short_name,
+                    strerror(err));
+            err = 0;
+        } else {
+            profiling = true;
+        }
+    }
+    struct monitor monitor;
+    bool monitoring = false;
+    if (monitor_file) {
+        err = monitor_start(&monitor, monitor_file, args.monitor_format,
+                            args.monitor_interval);
+        if (err) {
+            fprintf(stderr, "%s: monitor: %s\n", program_invocation_short_name,
+                    strerror(err));
+            err = 0;
+        } else {
+            monitoring = true;
+        }
+    }
+
+    /*
+     * Read the energy counters last, so that setting up profiling and
+     * monitoring is not charged to the benchmark.
+     */
+    if (energy) {
+        err = rapl_start(&rapl);
+        if (err) {
+            fprintf(stderr, "%s: warning: energy counters not readable: %s\n",
+                    program_invocation_short_name, strerror(err));
+            energy = false;
+            err = 0;
+        }
+    }
+#pragma omp parallel reduction(err_add:err) reduction(max:num_ops) reduction(max:repeat) \
+    reduction(+:minor_faults,major_faults) \
+    reduction(+:voluntary_context_switches,involuntary_context_switches)
+    {
+        if (observed_start)
+            affinity_observe(observed_start);
+        struct resource_usage usage_start, usage;
+        int usage_err = resource_usage_thread(&usage_start);
+        if (repetition_times) {
+            #pragma omp master
+            clock_gettime(CLOCK_MONOTONIC, &repetition_times[0]);
+        }
+        for (repeat = 0, num_ops = 0; (repeat < args.repeat) || (num_ops < args.min_ops); repeat++) {
+            err = benchmark_mathop(args.mathop, &input, &result, &num_ops);
+            bool stop = err == EINTR;
+            if (stop)
+                err = 0;
+            if (err)
+                break;
+            if (monitoring) {
+                #pragma omp master
+                monitor_progress(&monitor, num_ops);
+            }
+            if (repetition_times && repeat+1 < max_repetition_times) {
+                #pragma omp master
+                {
+                    clock_gettime(CLOCK_MONOTONIC, &repetition_times[repeat+1]);
+                    num_repetition_times = repeat+2;
+                }
+            }
+            if (stop) {
+                repeat++;
+                break;
+            }
+        }
+        if (!usage_err)
+            usage_err = resource_usage_thread(&usage);
+        if (observed_end)
+            affinity_observe(observed_end);
+        if (!usage_err) {
+            resource_usage_sub(&usage, &usage_start);
+            minor_faults += usage.minor_faults;
+            major_faults += usage.major_faults;
+            voluntary_context_switches += usage.voluntary_context_switches;
+            involuntary_context_switches += usage.involuntary_context_switches;
+        }
+    }
+    if (energy) {
+        int rapl_err = rapl_stop(&rapl);
+        if (rapl_err) {
+            fprintf(stderr, "%s: warning: energy counters not readable: %s\n",
+                    program_invocation_short_name, strerror(rapl_err));
+            energy = false;
+        }
+    }
+    mathop_result_merge_exceptions(&result);
+    if (profiling)
+        profile_stop(&profile);
+    if (args.rt)
+        rt_leave(&rt);
+    if (monitoring) {
+        int monitor_err = monitor_stop(&monitor);
+        if (monitor_err) {
+            fprintf(stderr, "%s: monitor: %s\n", program_invocation_short_name,
+                    strerror(monitor_err));
+        }
+    }
+    if (monitor_file && monitor_file != stdout)
+        fclose(monitor_file);
+    struct resource_usage usage = {
+        minor_faults, major_faults,
+        voluntary_context_switches, involuntary_context_switches};
+    if (interrupted) {
+        fprintf(stderr, "%s: interrupted by %s after %d repetitions; "
+                "later measurements are skipped\n",
+                program_invocation_short_name,
+                interrupted == SIGINT ? "SIGINT" : "SIGTERM", repeat);
     }
     if (err) {
         fprintf(stderr, "%s: %s\n", program_invocation_name,
                 strerror(err));
+        if (args.verbose > 0)
+            mathop_result_print_exceptions(&result, "exceptions: ", stderr);
+        if (args.exceptions == exceptions_detail && args.verbose > 0)
+            exceptions_detail_print(&input, &result, stderr);
         if (args.verbose > 1) {
             mathop_result_print(
                 &result, stderr, args.output_field_width,
@@ -153,6 +698,13 @@ int main(int argc, char *argv[])
         }
         mathop_result_free(&result);
         mathop_input_free(&input);
+        arena_free(&arena);
+        topology_free(&topology);
+        free(bind_cpus);
+        free(repetition_times);
+        free(osnoise_probes);
+        if (profiling)
+            profile_free(&profile);
         program_options_free(&args);
         return EXIT_FAILURE;
     }
@@ -160,7 +712,7 @@ int main(int argc, char *argv[])
     /* Display benchmark results. */
     if (args.verbose > 0) {
         clock_gettime(CLOCK_MONOTONIC, &t1);
-        double duration = timespec_duration(t0, t1);
+        duration = timespec_duration(t0, t1);
         double throughput = (double) num_ops / duration / 1000000.0;
         double abs_error, rel_error;
         const char * exceptions = NULL;
@@ -184,9 +736,660 @@ int main(int argc, char *argv[])
                     strerror(err));
             mathop_result_free(&result);
             mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            if (profiling)
+                profile_free(&profile);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        fprintf(stdout, "rusage: ");
+        resource_usage_print(&usage, stdout);
+        fputc('\n', stdout);
+        mathop_result_print_exceptions(&result, "exceptions: ", stdout);
+        fflush(stdout);
+    }
+
+    /*
+     * Classify every result to find the elements that raised each
+     * exception. This is done after the measurement, and not timed.
+     */
+    if (args.exceptions == exceptions_detail && args.verbose > 0) {
+        exceptions_detail_print(&input, &result, stdout);
+        fflush(stdout);
+    }
+
+    /* Display the energy consumed during the benchmark. */
+    if (energy && args.verbose > 0) {
+        fprintf(stdout, "energy: ");
+        rapl_print(&rapl, num_ops, stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+
+    /* Display which isolation steps succeeded. */
+    if (args.rt && args.verbose > 0) {
+        fprintf(stdout, "rt: ");
+        rt_print(&rt, stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+
+    /* Display a flat profile of the benchmark. */
+    if (profiling) {
+        if (args.verbose > 0) {
+            profile_print(&profile, 20, stdout);
+            fflush(stdout);
+        }
+        if (profile.num_lost > 0) {
+            fprintf(stderr, "%s: warning: profile: %"PRId64" samples were lost; "
+                    "the profile may be biased\n",
+                    program_invocation_short_name, profile.num_lost);
+        }
+        profile_free(&profile);
+    }
+
+    /*
+     * Warn if page faults were charged to the measured time, since
+     * they are then part of the time per operation.
+     */
+    if (usage.minor_faults > 0 || usage.major_faults > 0) {
+        fprintf(stderr, "%s: warning: %"PRId64" page faults occurred "
+                "during measurement (consider --prefault)\n",
+                program_invocation_short_name,
+                usage.minor_faults + usage.major_faults);
+    }
+
+    /*
+     * Measure the memory bandwidth and peak floating-point ceilings
+     * with the same threads, and place the math operation on the
+     * roofline.
+     */
+    if (args.roofline && !interrupted) {
+        struct roofline roofline;
+        err = roofline_measure(&roofline, 5);
+        if (err) {
+            fprintf(stderr, "%s: roofline: %s\n", program_invocation_short_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (args.verbose > 0) {
+            fprintf(stdout, "roofline: ");
+            roofline_print(&roofline, stdout);
+            fprintf(stdout, "\nroofline: ");
+            roofline_print_mathop(
+                &roofline, args.mathop, mathop_input_type_size(input.type),
+                mathop_result_type_size(result.type), num_ops, duration, stdout);
+            fputc('\n', stdout);
+            fflush(stdout);
+        }
+    }
+
+    /*
+     * Display the CPU topology and the binding of threads, and verify
+     * that each thread stayed on its CPU during the benchmark.
+     */
+    if (args.bind.type != affinity_none && args.verbose > 0) {
+        fprintf(stdout, "topology: ");
+        topology_print(&topology, stdout);
+        fprintf(stdout, "\nbind: ");
+        affinity_print(&args.bind, num_threads, bind_cpus,
+                       observed_start, observed_end, stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+
+    /*
+     * Display the operating system noise on each probed CPU, and the
+     * quietest CPUs to bind threads to. Warn if the repetitions varied
+     * more than the noise predicts, since the variation must then have
+     * some other cause, such as frequency scaling or contention.
+     */
+    if (osnoise_probes && args.verbose > 0) {
+        for (int i = 0; i < num_osnoise_probes; i++) {
+            fprintf(stdout, "osnoise: ");
+            osnoise_print(&osnoise_probes[i], stdout);
+            fputc('\n', stdout);
+        }
+        int quiet_cpus[num_threads];
+        int num_quiet_cpus = osnoise_recommend(
+            num_osnoise_probes, osnoise_probes, num_threads, quiet_cpus);
+        fprintf(stdout, "osnoise: quietest cpus: --bind=list:");
+        for (int i = 0; i < num_quiet_cpus; i++)
+            fprintf(stdout, i > 0 ? ",%d" : "%d", quiet_cpus[i]);
+        fputc('\n', stdout);
+
+        /* The first repetition warms up caches and is left out. */
+        int n = 0;
+        double sum = 0.0, sum_squares = 0.0;
+        for (int i = 2; i < num_repetition_times; i++) {
+            double t = timespec_duration(repetition_times[i-1], repetition_times[i]);
+            sum += t;
+            sum_squares += t * t;
+            n++;
+        }
+        if (n > 1) {
+            double mean = sum / n;
+            double variance = (sum_squares - n * mean * mean) / (n - 1);
+            double cv = variance > 0 && mean > 0 ? sqrt(variance) / mean : 0.0;
+            double predicted_cv = 0.0;
+            for (int i = 0; i < num_osnoise_probes; i++) {
+                double p = osnoise_predicted_cv(&osnoise_probes[i], mean);
+                if (predicted_cv < p)
+                    predicted_cv = p;
+            }
+            fprintf(stdout, "osnoise: %d repetitions of %.6f seconds "
+                    "cv: %.3f%% predicted cv: %.3f%%\n",
+                    n, mean, 100.0 * cv, 100.0 * predicted_cv);
+            if (cv > 3.0 * predicted_cv) {
+                fprintf(stderr, "%s: warning: repetitions vary more than "
+                        "operating system noise predicts (cv %.3f%% > 3 x %.3f%%)\n",
+                        program_invocation_short_name, 100.0 * cv,
+                        100.0 * predicted_cv);
+            }
+        }
+        fflush(stdout);
+    }
+
+    /* Display the NUMA placement of input and results. */
+    if (args.numa != mempolicy_default && args.verbose > 0) {
+        struct mempolicy_placement input_placement;
+        struct mempolicy_placement result_placement;
+        err = mathop_input_placement(&input, &input_placement);
+        if (!err)
+            err = mathop_result_placement(&result, &result_placement);
+        if (err) {
+            fprintf(stderr, "%s: NUMA placement: %s\n",
+                    program_invocation_short_name, strerror(err));
+        } else {
+            fprintf(stdout, "numa: %s input: ", mempolicy_str(args.numa));
+            mempolicy_placement_print(&input_placement, stdout);
+            fprintf(stdout, " result: ");
+            mempolicy_placement_print(&result_placement, stdout);
+            fputc('\n', stdout);
+        }
+        fflush(stdout);
+    }
+
+    /* Display the huge page coverage of the arena. */
+    if (args.hugepages != hugepages_none && args.verbose > 0) {
+        size_t hugepage_size;
+        err = arena_hugepage_size(&arena, &hugepage_size);
+        if (err) {
+            fprintf(stderr, "%s: huge pages: %s\n",
+                    program_invocation_short_name, strerror(err));
+        } else {
+            fprintf(stdout, "hugepages: %s arena: %zu bytes huge pages: "
+                    "%zu bytes (%.1f%%)\n",
+                    hugepages_str(args.hugepages), arena.size, hugepage_size,
+                    100.0 * hugepage_size / arena.size);
+        }
+        fflush(stdout);
+    }
+
+    /*
+     * Benchmark an identity copy and a call to an opaque function with
+     * the same loop and threads as the math operation, and subtract
+     * their time per operation from that of the math operation. The
+     * math operation is measured again, together with the baselines,
+     * and all of them write to a scratch result of the same size, so
+     * that the results and exceptions of the benchmark above are kept.
+     */
+    if (args.baseline && !interrupted) {
+        double seconds_per_op[num_mathop_baselines];
+        struct mathop_result baseline_result;
+        err = mathop_result_init(
+            &baseline_result, args.mathop, input.size, args.alignment);
+        baseline_result.stop = &interrupted;
+        for (int i = 0; !err && i < num_mathop_baselines; i++) {
+            if (interrupted) {
+                mathop_result_free(&baseline_result);
+                break;
+            }
+            int baseline_repeat;
+            int64_t baseline_num_ops;
+            double baseline_seconds;
+            err = benchmark(&args, args.mathop, i, &input, &baseline_result,
+                            &baseline_repeat, &baseline_num_ops, &baseline_seconds);
+            seconds_per_op[i] = baseline_seconds / baseline_num_ops;
+            if (i == num_mathop_baselines-1 || err)
+                mathop_result_free(&baseline_result);
+        }
+        if (err) {
+            fprintf(stderr, "%s: baseline: %s\n", program_invocation_short_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (interrupted) {
+            fprintf(stderr, "%s: baseline: interrupted, not reported\n",
+                    program_invocation_short_name);
+        } else if (args.verbose > 0) {
+            double t = seconds_per_op[mathop_baseline_none];
+            double t_copy = seconds_per_op[mathop_baseline_copy];
+            double t_call = seconds_per_op[mathop_baseline_call];
+            fprintf(stdout, "baseline: %s: %.6f Mops/s %.3f ns/op "
+                    "copy: %.6f Mops/s %.3f ns/op call: %.6f Mops/s %.3f ns/op",
+                    mathop_str(args.mathop), 1e-6 / t, 1e9 * t,
+                    1e-6 / t_copy, 1e9 * t_copy, 1e-6 / t_call, 1e9 * t_call);
+            if (t > t_copy) {
+                fprintf(stdout, " net of copy: %.6f Mops/s %.3f ns/op",
+                        1e-6 / (t - t_copy), 1e9 * (t - t_copy));
+            }
+            if (t > t_call) {
+                fprintf(stdout, " net of call: %.6f Mops/s %.3f ns/op",
+                        1e-6 / (t - t_call), 1e9 * (t - t_call));
+            }
+            fputc('\n', stdout);
+            if (t <= t_copy) {
+                fprintf(stderr, "%s: warning: %s is not slower than an "
+                        "identity copy\n", program_invocation_short_name,
+                        mathop_str(args.mathop));
+            }
+            if (t <= t_call) {
+                fprintf(stderr, "%s: warning: %s is not slower than a call to "
+                        "an empty function\n", program_invocation_short_name,
+                        mathop_str(args.mathop));
+            }
+            fflush(stdout);
+        }
+    }
+
+    /*
+     * Compare the math operation with another one by alternating
+     * short runs of both in a random order, so that drift in clock
+     * frequency or temperature affects both alike.
+     */
+    if (args.ab && !interrupted) {
+        struct mathop_input ab_input;
+        struct mathop_result ab_result;
+        double * ab_throughput = NULL;
+        bool have_ab = false;
+        err = mathop_input_copy(&ab_input, args.ab_mathop, &input, args.alignment);
+        if (!err) {
+            err = mathop_result_init(
+                &ab_result, args.ab_mathop, ab_input.size, args.alignment);
+            if (err)
+                mathop_input_free(&ab_input);
+            else
+                have_ab = true;
+        }
+
+        /* Place the input and results in the same way as those above. */
+        if (have_ab && (args.hugepages != hugepages_none ||
+                        args.numa != mempolicy_default)) {
+            struct arena * ab_arena =
+                args.hugepages != hugepages_none ? &arena : NULL;
+            err = mathop_input_place(&ab_input, args.alignment, args.numa, ab_arena);
+            if (!err) {
+                err = mathop_result_place(
+                    &ab_result, args.alignment, args.numa, ab_arena);
+            }
+        }
+        if (!err && have_ab && args.prefault) {
+            err = mathop_input_prefault(&ab_input);
+            if (!err)
+                err = mathop_result_prefault(&ab_result);
+        }
+        if (err && have_ab) {
+            mathop_result_free(&ab_result);
+            mathop_input_free(&ab_input);
+        }
+        if (!err)
+            ab_result.stop = &interrupted;
+        if (!err) {
+            ab_throughput = malloc(2 * args.ab_rounds * sizeof(double));
+            if (!ab_throughput) {
+                err = errno;
+                mathop_result_free(&ab_result);
+                mathop_input_free(&ab_input);
+            }
+        }
+        if (!err) {
+            double * a = ab_throughput;
+            double * b = &ab_throughput[args.ab_rounds];
+            uint64_t state = (uint64_t) time(NULL) ^ ((uint64_t) getpid() << 32);
+            for (int round = 0; !err && !interrupted && round < 2 * args.ab_rounds; round++) {
+                if (round % 2 == 0) {
+                    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                }
+                bool run_b = (round % 2) ^ (state & 1);
+                int ab_repeat;
+                int64_t ab_num_ops;
+                double ab_seconds;
+                err = benchmark(
+                    &args, run_b ? args.ab_mathop : args.mathop, mathop_baseline_none,
+                    run_b ? &ab_input : &input, run_b ? &ab_result : &result,
+                    &ab_repeat, &ab_num_ops, &ab_seconds);
+                double throughput = ab_num_ops / ab_seconds / 1000000.0;
+                if (run_b)
+                    b[round / 2] = throughput;
+                else
+                    a[round / 2] = throughput;
+            }
+            struct ratio_stats ratio;
+            if (!err && interrupted) {
+                fprintf(stderr, "%s: ab: interrupted, not reported\n",
+                        program_invocation_short_name);
+            } else if (!err) {
+                err = paired_ratio(args.ab_rounds, a, b, &ratio);
+            }
+            if (!err && !interrupted && args.verbose > 0) {
+                double mean_a = 0.0, mean_b = 0.0;
+                for (int round = 0; round < args.ab_rounds; round++) {
+                    mean_a += a[round] / args.ab_rounds;
+                    mean_b += b[round] / args.ab_rounds;
+                }
+                fprintf(stdout, "ab: %s: %.6f Mops/s %s: %.6f Mops/s %d rounds "
+                        "ratio: %.4f 95%% CI: [%.4f, %.4f] min: %.4f max: %.4f%s\n",
+                        mathop_str(args.mathop), mean_a,
+                        mathop_str(args.ab_mathop), mean_b, ratio.num_ratios,
+                        ratio.geomean, ratio.lower, ratio.upper, ratio.min, ratio.max,
+                        ratio.lower > 1.0 || ratio.upper < 1.0 ? "" : " (not significant)");
+                fflush(stdout);
+            }
+            free(ab_throughput);
+            mathop_result_free(&ab_result);
+            mathop_input_free(&ab_input);
+        }
+        if (err) {
+            fprintf(stderr, "%s: ab: %s\n", program_invocation_short_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * Benchmark the math operation again without and with each kind
+     * of background load running on other CPUs.
+     */
+    if (args.noise.num_types > 0 && !interrupted) {
+        int last_cpu = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+        int num_noise_cpus = args.noise_cpus ? args.num_noise_cpus : 1;
+        const int * noise_cpus = args.noise_cpus ? args.noise_cpus : &last_cpu;
+        int quiet_repeat;
+        int64_t quiet_num_ops;
+        double quiet_seconds;
+        err = benchmark(&args, args.mathop, mathop_baseline_none, &input, &result,
+                        &quiet_repeat, &quiet_num_ops, &quiet_seconds);
+        double quiet_throughput = quiet_num_ops / quiet_seconds / 1000000.0;
+        for (int i = 0; !err && !interrupted && i < args.noise.num_types; i++) {
+            struct noise noise;
+            int noise_repeat;
+            int64_t noise_num_ops;
+            double noise_seconds;
+            err = noise_start(&noise, args.noise.types[i],
+                              num_noise_cpus, noise_cpus);
+            if (err)
+                break;
+            err = benchmark(&args, args.mathop, mathop_baseline_none, &input, &result,
+                            &noise_repeat, &noise_num_ops, &noise_seconds);
+            int stop_err = noise_stop(&noise);
+            if (!err)
+                err = stop_err;
+            if (err || interrupted)
+                break;
+            if (args.verbose > 0) {
+                double throughput = noise_num_ops / noise_seconds / 1000000.0;
+                fprintf(stdout, "noise: %s on %d cpus: %.6f Mops/s "
+                        "(%.1f%% of %.6f Mops/s without noise) load: ",
+                        noise_type_str(noise.type), num_noise_cpus, throughput,
+                        100.0 * throughput / quiet_throughput, quiet_throughput);
+                noise_print(&noise, stdout);
+                fputc('\n', stdout);
+                fflush(stdout);
+            }
+        }
+        if (!err && interrupted) {
+            fprintf(stderr, "%s: noise: interrupted, not reported\n",
+                    program_invocation_short_name);
+        }
+        if (err) {
+            fprintf(stderr, "%s: noise: %s\n", program_invocation_short_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /*
+     * Benchmark the given math operations concurrently on their own
+     * CPUs, and compare with the throughput of each one alone.
+     */
+    if (args.corun.num_tasks > 0 && !interrupted) {
+        struct corun_result * corun_results = malloc(
+            args.corun.num_tasks * sizeof(struct corun_result));
+        err = corun_results ? 0 : errno;
+        if (!err) {
+            err = corun_benchmark(
+                &args.corun, &input, args.alignment, args.rounding_mode,
+                args.repeat, args.min_ops, corun_results);
+        }
+        if (err) {
+            fprintf(stderr, "%s: corun: %s\n", program_invocation_short_name,
+                    strerror(err));
+            free(corun_results);
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (args.verbose > 0)
+            corun_print(&args.corun, corun_results, stdout);
+        fflush(stdout);
+        free(corun_results);
+    }
+
+    /*
+     * Measure the overhead of OpenMP constructs for each thread
+     * count. With the largest number of threads, the overhead of the
+     * parallel region and the reduction, and, in every repetition, of
+     * one worksharing loop and the barrier of `benchmark_mathop()',
+     * which merges the errors of all threads, is an estimate of the
+     * synchronisation time included in the benchmark above.
+     */
+    if (args.omp_overhead && !interrupted) {
+        int thread_counts[32];
+        int num_thread_counts = ompbench_thread_counts(32, thread_counts);
+        struct ompbench_result omp_result;
+        err = 0;
+        for (int i = 0; !err && i < num_thread_counts; i++) {
+            err = ompbench(thread_counts[i], 1000, 20, &omp_result);
+            if (!err && args.verbose > 0)
+                ompbench_print(&omp_result, stdout);
+        }
+        if (err == ENOTSUP) {
+            fprintf(stderr, "%s: warning: omp-overhead: %s "
+                    "(built without OpenMP)\n",
+                    program_invocation_short_name, strerror(err));
+            err = 0;
+        } else if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        } else if (args.verbose > 0) {
+            double sync_time = omp_result.err_add +
+                repeat * (omp_result.for_static + omp_result.barrier);
+            fprintf(stdout, "omp-overhead: estimated synchronisation time: "
+                    "%.6f seconds (%.2f%% of measured time)",
+                    sync_time, duration > 0 ? 100.0 * sync_time / duration : 0.0);
+            if (duration > sync_time) {
+                fprintf(stdout, " corrected: %.6f seconds %.6f Mops/s\n",
+                        duration - sync_time,
+                        (double) num_ops / (duration - sync_time) / 1000000.0);
+            } else {
+                fputc('\n', stdout);
+                fprintf(stderr, "%s: warning: omp-overhead: synchronisation "
+                        "time exceeds the measured time\n",
+                        program_invocation_short_name);
+            }
+        }
+        fflush(stdout);
+    }
+
+    /*
+     * Measure the cost of floating-point environment calls with one
+     * thread and with the number of threads used above. Each thread
+     * clears and tests the exception flags once per repetition, and
+     * the time spent on this is subtracted from the measured time.
+     */
+    if (args.fenv_overhead && !interrupted) {
+        struct fenvbench_result fenv_result;
+        int fenv_thread_counts[2] = {1, num_threads};
+        int num_fenv_thread_counts = num_threads > 1 ? 2 : 1;
+        for (int i = 0; i < num_fenv_thread_counts; i++) {
+            err = fenvbench(fenv_thread_counts[i], 100000, 5, &fenv_result);
+            if (err) {
+                fprintf(stderr, "%s: %s\n", program_invocation_name,
+                        strerror(err));
+                mathop_result_free(&result);
+                mathop_input_free(&input);
+                arena_free(&arena);
+                topology_free(&topology);
+                free(bind_cpus);
+                free(repetition_times);
+                free(osnoise_probes);
+                program_options_free(&args);
+                return EXIT_FAILURE;
+            }
+            if (args.verbose > 0)
+                fenvbench_print(&fenv_result, stdout);
+        }
+        if (args.verbose > 0) {
+            double fenv_time = repeat * fenvbench_repetition_overhead(&fenv_result);
+            double net_duration = duration - fenv_time;
+            fprintf(stdout, "fenv-overhead: estimated time in fenv calls: "
+                    "%.6f seconds (%.2f%% of measured time) "
+                    "net: %.6f Mops/s\n",
+                    fenv_time, duration > 0 ? 100.0 * fenv_time / duration : 0.0,
+                    net_duration > 0 ? (double) num_ops / net_duration / 1000000.0 : 0.0);
+        }
+        fflush(stdout);
+    }
+
+    /*
+     * Evaluate the operation under downward and upward rounding to
+     * obtain an enclosure of every result.
+     */
+    if (args.interval && !interrupted) {
+        struct interval_result interval_result;
+        err = interval_benchmark(
+            args.mathop, &input, args.alignment, args.interval_block_size,
+            args.repeat, args.error_precision, &interval_result);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (args.verbose > 0)
+            interval_print(args.mathop, &interval_result, stdout);
+        fflush(stdout);
+    }
+
+    /*
+     * Measure the cost per call of the benchmark kernel on small
+     * batches of elements, where fixed costs dominate.
+     */
+    if (args.batch && !interrupted) {
+        struct batch_result batch_result;
+        err = batch_benchmark(
+            args.mathop, &input, args.alignment, &args.batch_sizes,
+            1000000, &batch_result);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
+            program_options_free(&args);
+            return EXIT_FAILURE;
+        }
+        if (args.verbose > 0)
+            batch_print(args.mathop, &batch_result, stdout);
+        fflush(stdout);
+    }
+
+    /*
+     * Compare calling the math function directly with calling it
+     * through a function pointer, through the PLT and inlined.
+     */
+    if (args.dispatch && !interrupted) {
+        struct dispatch_result dispatch_result;
+        err = dispatch_benchmark(
+            args.mathop, &input, args.alignment, args.repeat, &dispatch_result);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", program_invocation_name,
+                    strerror(err));
+            mathop_result_free(&result);
+            mathop_input_free(&input);
+            arena_free(&arena);
+            topology_free(&topology);
+            free(bind_cpus);
+            free(repetition_times);
+            free(osnoise_probes);
             program_options_free(&args);
             return EXIT_FAILURE;
         }
+        if (args.verbose > 0)
+            dispatch_print(args.mathop, &dispatch_result, stdout);
         fflush(stdout);
     }
 
@@ -200,6 +1403,11 @@ int main(int argc, char *argv[])
     /* Clean up. */
     mathop_result_free(&result);
     mathop_input_free(&input);
+    arena_free(&arena);
+    topology_free(&topology);
+    free(bind_cpus);
+    free(repetition_times);
+    free(osnoise_probes);
     program_options_free(&args);
     return EXIT_SUCCESS;
 }
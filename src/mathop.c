@@ -22,6 +22,8 @@
 
 #include "mathop.h"
 #include "fexcept.h"
+#include "mempolicy.h"
+#include "noop.h"
 #include "parse.h"
 #include "round.h"
 
@@ -29,6 +31,10 @@
 #include <mpfr.h>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <errno.h>
 #include <unistd.h>
 
@@ -55,6 +61,20 @@ const char * mathop_input_type_str(
     }
 }
 
+/**
+ * `mathop_input_type_size()` is the size in bytes of a single
+ * element of the given input type.
+ */
+size_t mathop_input_type_size(
+    enum mathop_input_type mathop_input_type)
+{
+    switch (mathop_input_type) {
+    case mathop_input_f32: return sizeof(float);
+    case mathop_input_f64: return sizeof(double);
+    default: return 0;
+    }
+}
+
 /**
  * `parse_mathop_input_type()` parses a string designating the input
  * type of a math operation.
@@ -560,6 +580,7 @@ int mathop_input_init(
 
     /* Read float values from the stream. */
     input->type = input_type;
+    input->arena = NULL;
     switch (input_type) {
     case mathop_input_f32:
         err = read_floats(f, alignment, &input->size, &input->f32);
@@ -579,6 +600,199 @@ int mathop_input_init(
     return 0;
 }
 
+/**
+ * `mathop_input_copy()` creates input for a math operation from the
+ * values of another input, converting them to the input type of the
+ * math operation, if needed.
+ */
+int mathop_input_copy(
+    struct mathop_input * input,
+    enum mathop mathop,
+    const struct mathop_input * src,
+    int alignment)
+{
+    int err;
+    enum mathop_input_type input_type;
+    err = mathop_input(mathop, &input_type);
+    if (err)
+        return err;
+    if (src->type != mathop_input_f32 && src->type != mathop_input_f64)
+        return EINVAL;
+
+    size_t type_size = mathop_input_type_size(input_type);
+    size_t size = src->size > 0 ? src->size * type_size : type_size;
+    size = ((size + alignment-1) / alignment) * alignment;
+    void * values = aligned_alloc(alignment, size);
+    if (!values)
+        return errno;
+
+    input->type = input_type;
+    input->size = src->size;
+    input->f32 = NULL;
+    input->f64 = NULL;
+    input->arena = NULL;
+    switch (input_type) {
+    case mathop_input_f32:
+        input->f32 = values;
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < src->size; i++) {
+            input->f32[i] = src->type == mathop_input_f32
+                ? src->f32[i] : (float) src->f64[i];
+        }
+        break;
+    case mathop_input_f64:
+        input->f64 = values;
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < src->size; i++) {
+            input->f64[i] = src->type == mathop_input_f32
+                ? (double) src->f32[i] : src->f64[i];
+        }
+        break;
+    default:
+        free(values);
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `place_fn(NAME, TYPE)` defines a function `NAME()` that moves an
+ * array of floating-point numbers of type `TYPE` to newly allocated
+ * storage that is placed according to a NUMA memory policy.
+ *
+ * The values are copied by multiple threads, using the same static
+ * partitioning of the array as the benchmark kernels, so that pages
+ * are first touched by the threads that later use them. If `arena`
+ * is not `NULL`, the storage is allocated from the arena. If
+ * `free_values` is `true`, the old storage is freed.
+ */
+#define place_fn(NAME, TYPE)                                            \
+    static int NAME(                                                    \
+        int64_t size,                                                   \
+        int alignment,                                                  \
+        enum mempolicy mempolicy,                                       \
+        struct arena * arena,                                           \
+        bool free_values,                                               \
+        TYPE ** values)                                                 \
+    {                                                                   \
+        long page_size = sysconf(_SC_PAGESIZE);                         \
+        if (alignment < page_size)                                      \
+            alignment = page_size;                                      \
+        int64_t aligned_size =                                          \
+            (((size * sizeof(TYPE)) + alignment-1) /                    \
+             alignment) * alignment;                                    \
+        if (aligned_size == 0)                                          \
+            aligned_size = alignment;                                   \
+        TYPE * new_values;                                              \
+        if (arena) {                                                    \
+            new_values = (TYPE *) arena_alloc(                          \
+                arena, aligned_size, alignment);                        \
+            if (!new_values)                                            \
+                return errno;                                           \
+        } else {                                                        \
+            new_values = (TYPE *) aligned_alloc(                        \
+                alignment, aligned_size);                               \
+            if (!new_values)                                            \
+                return errno;                                           \
+            int err = mempolicy_bind(                                   \
+                new_values, aligned_size, mempolicy);                   \
+            if (err) {                                                  \
+                free(new_values);                                       \
+                return err;                                             \
+            }                                                           \
+        }                                                               \
+        const TYPE * old_values = *values;                              \
+        _Pragma("omp parallel for schedule(static)")                    \
+        for (int64_t i = 0; i < size; i++)                              \
+            new_values[i] = old_values[i];                              \
+        if (free_values)                                                \
+            free(*values);                                              \
+        *values = new_values;                                           \
+        return 0;                                                       \
+    }                                                                   \
+
+
+place_fn(place_floats, float)
+place_fn(place_doubles, double)
+
+/**
+ * `mathop_input_place()` places the input of a math operation in
+ * memory according to a NUMA memory policy.
+ */
+int mathop_input_place(
+    struct mathop_input * input,
+    int alignment,
+    enum mempolicy mempolicy,
+    struct arena * arena)
+{
+    int err;
+    switch (input->type) {
+    case mathop_input_f32:
+        err = place_floats(
+            input->size, alignment, mempolicy, arena,
+            !input->arena, &input->f32);
+        break;
+    case mathop_input_f64:
+        err = place_doubles(
+            input->size, alignment, mempolicy, arena,
+            !input->arena, &input->f64);
+        break;
+    default:
+        return EINVAL;
+    }
+    if (err)
+        return err;
+    input->arena = arena;
+    return 0;
+}
+
+/**
+ * `mathop_input_placement()` finds the NUMA node of each page of the
+ * input of a math operation.
+ */
+int mathop_input_placement(
+    const struct mathop_input * input,
+    struct mempolicy_placement * placement)
+{
+    switch (input->type) {
+    case mathop_input_f32:
+        return mempolicy_placement(
+            input->f32, input->size * sizeof(float), placement);
+    case mathop_input_f64:
+        return mempolicy_placement(
+            input->f64, input->size * sizeof(double), placement);
+    default:
+        return EINVAL;
+    }
+}
+
+/**
+ * `mathop_input_prefault()` reads every element of the input of a
+ * math operation, so that page faults are taken before the benchmark.
+ */
+int mathop_input_prefault(
+    const struct mathop_input * input)
+{
+    double sum = 0.0;
+    switch (input->type) {
+    case mathop_input_f32:
+#pragma omp parallel for schedule(static) reduction(+:sum)
+        for (int64_t i = 0; i < input->size; i++)
+            sum += input->f32[i];
+        break;
+    case mathop_input_f64:
+#pragma omp parallel for schedule(static) reduction(+:sum)
+        for (int64_t i = 0; i < input->size; i++)
+            sum += input->f64[i];
+        break;
+    default:
+        return EINVAL;
+    }
+    volatile double sink = sum;
+    (void) sink;
+    return 0;
+}
+
 /**
  * `mathop_input_free()` frees resources associated with an input for
  * a math operation.
@@ -586,6 +800,8 @@ int mathop_input_init(
 int mathop_input_free(
     struct mathop_input * input)
 {
+    if (input->arena)
+        return 0;
     switch (input->type) {
     case mathop_input_f32:
         free(input->f32);
@@ -644,6 +860,20 @@ const char * mathop_result_type_str(
     }
 }
 
+/**
+ * `mathop_result_type_size()` is the size in bytes of a single
+ * element of the given result type.
+ */
+size_t mathop_result_type_size(
+    enum mathop_result_type mathop_result_type)
+{
+    switch (mathop_result_type) {
+    case mathop_result_f32: return sizeof(float);
+    case mathop_result_f64: return sizeof(double);
+    default: return 0;
+    }
+}
+
 /**
  * `parse_mathop_result_type()` parses a string designating the result
  * type of a math operation.
@@ -685,7 +915,7 @@ int mathop_result_init_float_array(
     if (!result->f32)
         return errno;
 
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (int64_t i = 0; i < result->size; i++)
         result->f32[i] = 0.0f;
     return 0;
@@ -710,12 +940,79 @@ int mathop_result_init_double_array(
     if (!result->f64)
         return errno;
 
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (int64_t i = 0; i < result->size; i++)
         result->f64[i] = 0.0;
     return 0;
 }
 
+/**
+ * `thread_num()` is the OpenMP thread number of the calling thread.
+ */
+static int thread_num(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * `team_size()` is the number of threads in the current OpenMP team.
+ */
+static int team_size(void)
+{
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+/**
+ * `mathop_result_init_threads()` allocates the exception state of
+ * each thread and finds the partition of the result that each thread
+ * computes.
+ */
+static int mathop_result_init_threads(
+    struct mathop_result * result)
+{
+#ifdef _OPENMP
+    result->num_threads = omp_get_max_threads();
+#else
+    result->num_threads = 1;
+#endif
+    result->threads = aligned_alloc(
+        64, result->num_threads * sizeof(struct mathop_thread_state));
+    if (!result->threads)
+        return errno;
+    result->record_threads = true;
+    result->stop = NULL;
+    memset(result->threads, 0,
+           result->num_threads * sizeof(struct mathop_thread_state));
+
+    /*
+     * The benchmark kernels use the same static schedule, so each
+     * thread computes the same partition in every repetition.
+     */
+    int64_t size = result->size;
+    struct mathop_thread_state * threads = result->threads;
+    #pragma omp parallel num_threads(result->num_threads)
+    {
+        int64_t begin = size, end = 0;
+        #pragma omp for schedule(static)
+        for (int64_t i = 0; i < size; i++) {
+            if (begin > i)
+                begin = i;
+            end = i+1;
+        }
+        threads[thread_num()].begin = begin < end ? begin : 0;
+        threads[thread_num()].end = end;
+    }
+    return 0;
+}
+
 /**
  * `mathop_result_init()` allocates storage for the result for a math
  * operation.
@@ -728,6 +1025,7 @@ int mathop_result_init(
 {
     int err;
     fexcept_clear(&result->fexcept);
+    result->arena = NULL;
 
     switch (mathop) {
     case mathop_cos:
@@ -796,6 +1094,89 @@ int mathop_result_init(
         return EINVAL;
     }
 
+    err = mathop_result_init_threads(result);
+    if (err) {
+        if (result->type == mathop_result_f32)
+            free(result->f32);
+        else
+            free(result->f64);
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `mathop_result_place()` places the result of a math operation in
+ * memory according to a NUMA memory policy.
+ */
+int mathop_result_place(
+    struct mathop_result * result,
+    int alignment,
+    enum mempolicy mempolicy,
+    struct arena * arena)
+{
+    int err;
+    switch (result->type) {
+    case mathop_result_f32:
+        err = place_floats(
+            result->size, alignment, mempolicy, arena,
+            !result->arena, &result->f32);
+        break;
+    case mathop_result_f64:
+        err = place_doubles(
+            result->size, alignment, mempolicy, arena,
+            !result->arena, &result->f64);
+        break;
+    default:
+        return EINVAL;
+    }
+    if (err)
+        return err;
+    result->arena = arena;
+    return 0;
+}
+
+/**
+ * `mathop_result_placement()` finds the NUMA node of each page of the
+ * result of a math operation.
+ */
+int mathop_result_placement(
+    const struct mathop_result * result,
+    struct mempolicy_placement * placement)
+{
+    switch (result->type) {
+    case mathop_result_f32:
+        return mempolicy_placement(
+            result->f32, result->size * sizeof(float), placement);
+    case mathop_result_f64:
+        return mempolicy_placement(
+            result->f64, result->size * sizeof(double), placement);
+    default:
+        return EINVAL;
+    }
+}
+
+/**
+ * `mathop_result_prefault()` writes every element of the result of a
+ * math operation, so that page faults are taken before the benchmark.
+ */
+int mathop_result_prefault(
+    struct mathop_result * result)
+{
+    switch (result->type) {
+    case mathop_result_f32:
+#pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < result->size; i++)
+            result->f32[i] = 0.0f;
+        break;
+    case mathop_result_f64:
+#pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < result->size; i++)
+            result->f64[i] = 0.0;
+        break;
+    default:
+        return EINVAL;
+    }
     return 0;
 }
 
@@ -806,6 +1187,10 @@ int mathop_result_init(
 int mathop_result_free(
     struct mathop_result * result)
 {
+    free(result->threads);
+    result->threads = NULL;
+    if (result->arena)
+        return 0;
     switch (result->type) {
     case mathop_result_f32:
         free(result->f32);
@@ -819,6 +1204,42 @@ int mathop_result_free(
     return 0;
 }
 
+/**
+ * `mathop_result_merge_exceptions()` combines the floating-point
+ * exceptions raised by each thread and stores them in
+ * `result->fexcept`.
+ */
+void mathop_result_merge_exceptions(
+    struct mathop_result * result)
+{
+    int excepts = 0;
+    for (int i = 0; i < result->num_threads; i++)
+        excepts |= result->threads[i].excepts;
+    fexcept_set(&result->fexcept, excepts);
+}
+
+/**
+ * `mathop_result_print_exceptions()` prints the floating-point
+ * exceptions and error numbers raised by each thread.
+ */
+void mathop_result_print_exceptions(
+    const struct mathop_result * result,
+    const char * prefix,
+    FILE * f)
+{
+    for (int i = 0; i < result->num_threads; i++) {
+        const struct mathop_thread_state * thread = &result->threads[i];
+        if (!thread->excepts && !thread->errnum)
+            continue;
+        fprintf(f, "%sthread %d elements [%"PRId64", %"PRId64"): %s",
+                prefix, i, thread->begin, thread->end,
+                fexcept_excepts_str(thread->excepts));
+        if (thread->errnum)
+            fprintf(f, " errno: %s", strerror(thread->errnum));
+        fputc('\n', f);
+    }
+}
+
 /**
  * `mathop_result_has_exception()` returns `true` if there is a
  * floating-point exception associated with the given result.
@@ -874,7 +1295,7 @@ int mathop_result_print(
     {                                                                   \
         if (N != result->size || result->type != mathop_result_f32)     \
             return EINVAL;                                              \
-        _Pragma("omp for simd")                                         \
+        _Pragma("omp for simd schedule(static)")                        \
         for (int64_t i = 0; i < N; i++)                                 \
             result->f32[i] = OPNAME(x[i]);                              \
         (*num_ops) += N;                                                \
@@ -891,7 +1312,7 @@ int mathop_result_print(
     {                                                                   \
         if (N != result->size || result->type != mathop_result_f64)     \
             return EINVAL;                                              \
-        _Pragma("omp for simd")                                         \
+        _Pragma("omp for simd schedule(static)")                        \
         for (int64_t i = 0; i < N; i++)                                 \
             result->f64[i] = OPNAME(x[i]);                              \
         (*num_ops) += N;                                                \
@@ -899,56 +1320,65 @@ int mathop_result_print(
     }                                                                   \
 
 
-benchmark_mathop_fn_double(cos)
-benchmark_mathop_fn_float(cosf)
-benchmark_mathop_fn_double(sin)
-benchmark_mathop_fn_float(sinf)
-benchmark_mathop_fn_double(tan)
-benchmark_mathop_fn_float(tanf)
-benchmark_mathop_fn_double(acos)
-benchmark_mathop_fn_float(acosf)
-benchmark_mathop_fn_double(asin)
-benchmark_mathop_fn_float(asinf)
-benchmark_mathop_fn_double(atan)
-benchmark_mathop_fn_float(atanf)
-benchmark_mathop_fn_double(cosh)
-benchmark_mathop_fn_float(coshf)
-benchmark_mathop_fn_double(sinh)
-benchmark_mathop_fn_float(sinhf)
-benchmark_mathop_fn_double(tanh)
-benchmark_mathop_fn_float(tanhf)
-benchmark_mathop_fn_double(acosh)
-benchmark_mathop_fn_float(acoshf)
-benchmark_mathop_fn_double(asinh)
-benchmark_mathop_fn_float(asinhf)
-benchmark_mathop_fn_double(atanh)
-benchmark_mathop_fn_float(atanhf)
-benchmark_mathop_fn_double(exp)
-benchmark_mathop_fn_float(expf)
-benchmark_mathop_fn_double(log)
-benchmark_mathop_fn_float(logf)
-benchmark_mathop_fn_double(log10)
-benchmark_mathop_fn_float(log10f)
-benchmark_mathop_fn_double(exp2)
-benchmark_mathop_fn_float(exp2f)
-benchmark_mathop_fn_double(expm1)
-benchmark_mathop_fn_float(expm1f)
-benchmark_mathop_fn_double(log1p)
-benchmark_mathop_fn_float(log1pf)
-benchmark_mathop_fn_double(log2)
-benchmark_mathop_fn_float(log2f)
-benchmark_mathop_fn_double(sqrt)
-benchmark_mathop_fn_float(sqrtf)
-benchmark_mathop_fn_double(cbrt)
-benchmark_mathop_fn_float(cbrtf)
-benchmark_mathop_fn_double(erf)
-benchmark_mathop_fn_float(erff)
-benchmark_mathop_fn_double(erfc)
-benchmark_mathop_fn_float(erfcf)
-benchmark_mathop_fn_double(tgamma)
-benchmark_mathop_fn_float(tgammaf)
-benchmark_mathop_fn_double(lgamma)
-benchmark_mathop_fn_float(lgammaf)
+#define benchmark_mathop_fn_type(OPNAME, TYPE) \
+    benchmark_mathop_fn_ ## TYPE(OPNAME)
+mathop_fns(benchmark_mathop_fn_type)
+
+/*
+ * Baseline kernels that copy their input or call an opaque function
+ * instead of computing a math function.
+ */
+
+static inline double identity(double x) { return x; }
+static inline float identityf(float x) { return x; }
+
+benchmark_mathop_fn_double(identity)
+benchmark_mathop_fn_float(identityf)
+benchmark_mathop_fn_double(noop)
+benchmark_mathop_fn_float(noopf)
+
+/**
+ * `mathop_result_exchange_status()` combines the error numbers of the
+ * threads of a team after a repetition, so that every thread returns
+ * the same value.
+ *
+ * The first error of any thread is returned. Otherwise, if the master
+ * thread finds that `result->stop` is set, `EINTR` is returned to ask
+ * every thread to stop after this repetition. A thread only writes its
+ * status again after the worksharing loop of the next repetition,
+ * which no thread leaves before the others have read the statuses.
+ */
+static int mathop_result_exchange_status(
+    struct mathop_result * result,
+    int errnum)
+{
+    struct mathop_thread_state * thread = &result->threads[thread_num()];
+    thread->status = errnum;
+    if (!errnum && thread_num() == 0 && result->stop && *result->stop)
+        thread->status = EINTR;
+    #pragma omp barrier
+    int status = 0;
+    int num_threads = team_size();
+    for (int i = 0; i < num_threads; i++) {
+        int s = result->threads[i].status;
+        if (s && (!status || status == EINTR))
+            status = s;
+    }
+    return status;
+}
+
+#define benchmark_mathop_case_float(OPNAME)                             \
+    case mathop_ ## OPNAME:                                             \
+        err = benchmark_mathop_ ## OPNAME(                              \
+            input->size, input->f32, result, num_ops);                  \
+        break;
+#define benchmark_mathop_case_double(OPNAME)                            \
+    case mathop_ ## OPNAME:                                             \
+        err = benchmark_mathop_ ## OPNAME(                              \
+            input->size, input->f64, result, num_ops);                  \
+        break;
+#define benchmark_mathop_case(OPNAME, TYPE) \
+    benchmark_mathop_case_ ## TYPE(OPNAME)
 
 /**
  * `benchmark_mathop()` benchmarks a math operation.
@@ -961,174 +1391,84 @@ int benchmark_mathop(
 {
     int err;
 
+    /*
+     * Every thread of the team must have its own state, so that all
+     * of them reach the barrier below. The team size is the same for
+     * every thread, so a team that is too large is rejected by all.
+     */
+    if (result->record_threads && team_size() > result->num_threads)
+        return EINVAL;
+
     errno = 0;
     if (math_errhandling & MATH_ERREXCEPT)
         feclearexcept(FE_ALL_EXCEPT);
 
     switch (mathop) {
-    case mathop_cos:
-        err = benchmark_mathop_cos(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_cosf:
-        err = benchmark_mathop_cosf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_sin:
-        err = benchmark_mathop_sin(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_sinf:
-        err = benchmark_mathop_sinf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_tan:
-        err = benchmark_mathop_tan(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_tanf:
-        err = benchmark_mathop_tanf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_acos:
-        err = benchmark_mathop_acos(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_acosf:
-        err = benchmark_mathop_acosf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_asin:
-        err = benchmark_mathop_asin(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_asinf:
-        err = benchmark_mathop_asinf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_atan:
-        err = benchmark_mathop_atan(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_atanf:
-        err = benchmark_mathop_atanf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_cosh:
-        err = benchmark_mathop_cosh(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_coshf:
-        err = benchmark_mathop_coshf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_sinh:
-        err = benchmark_mathop_sinh(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_sinhf:
-        err = benchmark_mathop_sinhf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_tanh:
-        err = benchmark_mathop_tanh(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_tanhf:
-        err = benchmark_mathop_tanhf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_acosh:
-        err = benchmark_mathop_acosh(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_acoshf:
-        err = benchmark_mathop_acoshf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_asinh:
-        err = benchmark_mathop_asinh(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_asinhf:
-        err = benchmark_mathop_asinhf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_atanh:
-        err = benchmark_mathop_atanh(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_atanhf:
-        err = benchmark_mathop_atanhf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_exp:
-        err = benchmark_mathop_exp(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_expf:
-        err = benchmark_mathop_expf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_log:
-        err = benchmark_mathop_log(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_logf:
-        err = benchmark_mathop_logf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_log10:
-        err = benchmark_mathop_log10(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_log10f:
-        err = benchmark_mathop_log10f(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_exp2:
-        err = benchmark_mathop_exp2(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_exp2f:
-        err = benchmark_mathop_exp2f(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_expm1:
-        err = benchmark_mathop_expm1(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_expm1f:
-        err = benchmark_mathop_expm1f(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_log1p:
-        err = benchmark_mathop_log1p(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_log1pf:
-        err = benchmark_mathop_log1pf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_log2:
-        err = benchmark_mathop_log2(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_log2f:
-        err = benchmark_mathop_log2f(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_sqrt:
-        err = benchmark_mathop_sqrt(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_sqrtf:
-        err = benchmark_mathop_sqrtf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_cbrt:
-        err = benchmark_mathop_cbrt(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_cbrtf:
-        err = benchmark_mathop_cbrtf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_erf:
-        err = benchmark_mathop_erf(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_erff:
-        err = benchmark_mathop_erff(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_erfc:
-        err = benchmark_mathop_erfc(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_erfcf:
-        err = benchmark_mathop_erfcf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_tgamma:
-        err = benchmark_mathop_tgamma(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_tgammaf:
-        err = benchmark_mathop_tgammaf(input->size, input->f32, result, num_ops);
-        break;
-    case mathop_lgamma:
-        err = benchmark_mathop_lgamma(input->size, input->f64, result, num_ops);
-        break;
-    case mathop_lgammaf:
-        err = benchmark_mathop_lgammaf(input->size, input->f32, result, num_ops);
-        break;
+    mathop_fns(benchmark_mathop_case)
     default:
         return EINVAL;
     }
     if (err)
         return err;
 
-    fexcept_store(&result->fexcept, FE_ALL_EXCEPT & ~FE_INEXACT);
-    if (math_errhandling & MATH_ERRNO) {
-        if (errno)
-            return errno;
+    /*
+     * Record the exceptions and errno of this thread in its own state,
+     * to be merged with those of other threads after the benchmark.
+     */
+    int errnum = (math_errhandling & MATH_ERRNO) ? errno : 0;
+    if (!result->record_threads)
+        return errnum;
+    struct mathop_thread_state * thread = &result->threads[thread_num()];
+    if (math_errhandling & MATH_ERREXCEPT)
+        thread->excepts |= fetestexcept(FE_ALL_EXCEPT & ~FE_INEXACT);
+    if (errnum)
+        thread->errnum = errnum;
+    return mathop_result_exchange_status(result, errnum);
+}
+
+/**
+ * `mathop_baseline_str()` is a string representing a given baseline
+ * kernel.
+ */
+const char * mathop_baseline_str(
+    enum mathop_baseline baseline)
+{
+    switch (baseline) {
+    case mathop_baseline_none: return "none";
+    case mathop_baseline_copy: return "copy";
+    case mathop_baseline_call: return "call";
+    default: return "unknown";
     }
+}
 
-    return 0;
+/**
+ * `benchmark_mathop_baseline()` benchmarks a baseline kernel with
+ * the same loop structure, threading and buffers as the kernels used
+ * by `benchmark_mathop()`.
+ */
+int benchmark_mathop_baseline(
+    enum mathop_baseline baseline,
+    struct mathop_input * input,
+    struct mathop_result * result,
+    int64_t * num_ops)
+{
+    if (result->record_threads && team_size() > result->num_threads)
+        return EINVAL;
+    int err;
+    if (baseline == mathop_baseline_copy && input->type == mathop_input_f32) {
+        err = benchmark_mathop_identityf(input->size, input->f32, result, num_ops);
+    } else if (baseline == mathop_baseline_copy && input->type == mathop_input_f64) {
+        err = benchmark_mathop_identity(input->size, input->f64, result, num_ops);
+    } else if (baseline == mathop_baseline_call && input->type == mathop_input_f32) {
+        err = benchmark_mathop_noopf(input->size, input->f32, result, num_ops);
+    } else if (baseline == mathop_baseline_call && input->type == mathop_input_f64) {
+        err = benchmark_mathop_noop(input->size, input->f64, result, num_ops);
+    } else {
+        return EINVAL;
+    }
+    if (err || !result->record_threads)
+        return err;
+    return mathop_result_exchange_status(result, 0);
 }
 
 #ifdef HAVE_MPFR
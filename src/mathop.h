@@ -23,9 +23,12 @@
 #ifndef MATHOP_H
 #define MATHOP_H
 
+#include "arena.h"
+#include "mempolicy.h"
 #include "round.h"
 
 #include <fenv.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -50,6 +53,13 @@ enum mathop_input_type
 const char * mathop_input_type_str(
     enum mathop_input_type mathop_input_type);
 
+/**
+ * `mathop_input_type_size()` is the size in bytes of a single
+ * element of the given input type.
+ */
+size_t mathop_input_type_size(
+    enum mathop_input_type mathop_input_type);
+
 /**
  * `parse_mathop_input_type()` parses a string designating the input
  * type of a math operation.
@@ -132,6 +142,62 @@ enum mathop
     num_mathops
 };
 
+/**
+ * `mathop_fns()` expands `X(OPNAME, TYPE)` for the math function of
+ * each math operation, where `TYPE` is `float` or `double`.
+ */
+#define mathop_fns(X)                                                   \
+    X(cos, double)                                                      \
+    X(cosf, float)                                                      \
+    X(sin, double)                                                      \
+    X(sinf, float)                                                      \
+    X(tan, double)                                                      \
+    X(tanf, float)                                                      \
+    X(acos, double)                                                     \
+    X(acosf, float)                                                     \
+    X(asin, double)                                                     \
+    X(asinf, float)                                                     \
+    X(atan, double)                                                     \
+    X(atanf, float)                                                     \
+    X(cosh, double)                                                     \
+    X(coshf, float)                                                     \
+    X(sinh, double)                                                     \
+    X(sinhf, float)                                                     \
+    X(tanh, double)                                                     \
+    X(tanhf, float)                                                     \
+    X(acosh, double)                                                    \
+    X(acoshf, float)                                                    \
+    X(asinh, double)                                                    \
+    X(asinhf, float)                                                    \
+    X(atanh, double)                                                    \
+    X(atanhf, float)                                                    \
+    X(exp, double)                                                      \
+    X(expf, float)                                                      \
+    X(log, double)                                                      \
+    X(logf, float)                                                      \
+    X(log10, double)                                                    \
+    X(log10f, float)                                                    \
+    X(exp2, double)                                                     \
+    X(exp2f, float)                                                     \
+    X(expm1, double)                                                    \
+    X(expm1f, float)                                                    \
+    X(log1p, double)                                                    \
+    X(log1pf, float)                                                    \
+    X(log2, double)                                                     \
+    X(log2f, float)                                                     \
+    X(sqrt, double)                                                     \
+    X(sqrtf, float)                                                     \
+    X(cbrt, double)                                                     \
+    X(cbrtf, float)                                                     \
+    X(erf, double)                                                      \
+    X(erff, float)                                                      \
+    X(erfc, double)                                                     \
+    X(erfcf, float)                                                     \
+    X(tgamma, double)                                                   \
+    X(tgammaf, float)                                                   \
+    X(lgamma, double)                                                   \
+    X(lgammaf, float)
+
 /**
  * `mathop_str()` is a string representing a given math operation.
  */
@@ -167,6 +233,7 @@ struct mathop_input
     int64_t size;
     float * f32;
     double * f64;
+    struct arena * arena;
 };
 
 /**
@@ -179,6 +246,62 @@ int mathop_input_init(
     FILE * f,
     int alignment);
 
+/**
+ * `mathop_input_copy()` creates input for a math operation from the
+ * values of another input, converting them to the input type of the
+ * math operation, if needed.
+ *
+ * The values are copied by multiple threads, using the same static
+ * partitioning of the array as the benchmark kernels, so that pages
+ * are first touched by the threads that later use them. A caller with
+ * a single OpenMP thread, such as a co-run thread, touches every page
+ * itself.
+ */
+int mathop_input_copy(
+    struct mathop_input * input,
+    enum mathop mathop,
+    const struct mathop_input * src,
+    int alignment);
+
+/**
+ * `mathop_input_place()` places the input of a math operation in
+ * memory according to a NUMA memory policy.
+ *
+ * The input is copied to newly allocated, page-aligned storage by
+ * multiple threads, using the same static partitioning of elements
+ * among threads as `benchmark_mathop()`. For the first-touch policy,
+ * each page thereby ends up on the NUMA node of the thread that
+ * reads it during the benchmark. For other policies, the storage is
+ * bound with `mbind()` before it is touched.
+ *
+ * If `arena` is not `NULL`, then the storage is allocated from the
+ * given arena, and it is assumed that the memory policy has already
+ * been applied to the arena as a whole. The arena must outlive the
+ * input.
+ */
+int mathop_input_place(
+    struct mathop_input * input,
+    int alignment,
+    enum mempolicy mempolicy,
+    struct arena * arena);
+
+/**
+ * `mathop_input_placement()` finds the NUMA node of each page of the
+ * input of a math operation.
+ */
+int mathop_input_placement(
+    const struct mathop_input * input,
+    struct mempolicy_placement * placement);
+
+/**
+ * `mathop_input_prefault()` reads every element of the input of a
+ * math operation, using the same static partitioning of elements
+ * among threads as `benchmark_mathop()`, so that page faults are
+ * taken before, rather than during, the benchmark.
+ */
+int mathop_input_prefault(
+    const struct mathop_input * input);
+
 /**
  * `mathop_input_free()` frees resources associated with an input for
  * a math operation.
@@ -216,6 +339,13 @@ enum mathop_result_type
 const char * mathop_result_type_str(
     enum mathop_result_type mathop_result_type);
 
+/**
+ * `mathop_result_type_size()` is the size in bytes of a single
+ * element of the given result type.
+ */
+size_t mathop_result_type_size(
+    enum mathop_result_type mathop_result_type);
+
 /**
  * `parse_mathop_result_type()` parses a string designating the result
  * type of a math operation.
@@ -228,9 +358,43 @@ int parse_mathop_result_type(
     const char * s,
     enum mathop_result_type * result);
 
+/**
+ * `mathop_thread_state` is the floating-point exceptions and error
+ * number raised by one thread while computing its partition,
+ * `[begin, end)`, of the result of a math operation.
+ *
+ * Exception flags and `errno` are thread-local, so each thread
+ * records them in its own state, which is aligned to a cache line to
+ * avoid false sharing. `excepts` and `errnum` accumulate over all
+ * repetitions, whereas `status` is the error number of the most
+ * recent repetition, which is merged with those of the other threads
+ * of the team.
+ */
+struct mathop_thread_state
+{
+    _Alignas(64) int excepts;
+    int errnum;
+    int status;
+    int64_t begin;
+    int64_t end;
+};
+
+_Static_assert(sizeof(struct mathop_thread_state) % 64 == 0,
+               "mathop_thread_state must fill whole cache lines");
+
 /**
  * `mathop_result` is a data structure used to represent results from
  * common mathematical operations.
+ *
+ * `fexcept` holds the union of the exceptions raised by all threads,
+ * once they have been merged by `mathop_result_merge_exceptions()`.
+ *
+ * If `record_threads` is true, then each thread of the team that
+ * computes the result records its exceptions and errno in `threads`,
+ * and the threads agree on the error number to return. Otherwise,
+ * each thread only returns its own error number. If `stop` is not
+ * `NULL' and becomes nonzero, then every thread returns `EINTR' after
+ * the current repetition.
  */
 struct mathop_result
 {
@@ -239,6 +403,11 @@ struct mathop_result
     int64_t size;
     float * f32;
     double * f64;
+    struct arena * arena;
+    bool record_threads;
+    const volatile sig_atomic_t * stop;
+    int num_threads;
+    struct mathop_thread_state * threads;
 };
 
 /**
@@ -251,6 +420,34 @@ int mathop_result_init(
     int64_t size,
     int alignment);
 
+/**
+ * `mathop_result_place()` places the result of a math operation in
+ * memory according to a NUMA memory policy.
+ *
+ * See `mathop_input_place()`.
+ */
+int mathop_result_place(
+    struct mathop_result * result,
+    int alignment,
+    enum mempolicy mempolicy,
+    struct arena * arena);
+
+/**
+ * `mathop_result_placement()` finds the NUMA node of each page of
+ * the result of a math operation.
+ */
+int mathop_result_placement(
+    const struct mathop_result * result,
+    struct mempolicy_placement * placement);
+
+/**
+ * `mathop_result_prefault()` writes every element of the result of a
+ * math operation, using the same static partitioning of elements
+ * among threads as `benchmark_mathop()`.
+ */
+int mathop_result_prefault(
+    struct mathop_result * result);
+
 /**
  * `mathop_result_free()` frees resources associated with the result
  * of a math operation.
@@ -258,6 +455,30 @@ int mathop_result_init(
 int mathop_result_free(
     struct mathop_result * result);
 
+/**
+ * `mathop_result_merge_exceptions()` combines the floating-point
+ * exceptions raised by each thread, with a bitwise OR, and stores
+ * them in `result->fexcept`.
+ *
+ * This must be called after the parallel region in which the math
+ * operation was benchmarked, and before the exceptions are reported.
+ */
+void mathop_result_merge_exceptions(
+    struct mathop_result * result);
+
+/**
+ * `mathop_result_print_exceptions()` prints the floating-point
+ * exceptions and error numbers raised by each thread, together with
+ * the partition of the result computed by the thread.
+ *
+ * Only threads that raised an exception or set `errno` are printed,
+ * one per line, each line beginning with `prefix`.
+ */
+void mathop_result_print_exceptions(
+    const struct mathop_result * result,
+    const char * prefix,
+    FILE * f);
+
 /**
  * `mathop_result_has_exception()` returns `true` if there is a
  * floating-point exception associated with the given result.
@@ -277,6 +498,13 @@ int mathop_result_print(
 
 /**
  * `benchmark_mathop()` benchmarks a math operation.
+ *
+ * If it is called by every thread of a parallel region, then each
+ * thread computes its own partition of the result. If any thread sets
+ * `errno', then every thread returns the same error number, so that
+ * all threads leave a repetition loop together, and none of them is
+ * left waiting at a barrier. If `result->stop` is set, then every
+ * thread returns `EINTR' once the repetition is complete.
  */
 int benchmark_mathop(
     enum mathop mathop,
@@ -284,6 +512,44 @@ int benchmark_mathop(
     struct mathop_result * result,
     int64_t * num_ops);
 
+/**
+ * `mathop_baseline` is used to enumerate kernels that measure the
+ * overhead of the benchmark harness, rather than a math operation.
+ */
+enum mathop_baseline
+{
+    mathop_baseline_none = 0, /* the math operation itself */
+    mathop_baseline_copy,     /* copy each input element to the result */
+    mathop_baseline_call,     /* call an opaque function returning its argument */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_mathop_baselines
+};
+
+/**
+ * `mathop_baseline_str()` is a string representing a given baseline
+ * kernel.
+ */
+const char * mathop_baseline_str(
+    enum mathop_baseline baseline);
+
+/**
+ * `benchmark_mathop_baseline()` benchmarks a baseline kernel with
+ * the same loop structure, threading and buffers as the kernels used
+ * by `benchmark_mathop()`.
+ *
+ * The identity copy measures the loop and memory traffic, and the
+ * call to an opaque function, `noop()` or `noopf()`, additionally
+ * measures the cost of a function call. The element type is given by
+ * the input. Errors and `result->stop` are handled as by
+ * `benchmark_mathop()`.
+ */
+int benchmark_mathop_baseline(
+    enum mathop_baseline baseline,
+    struct mathop_input * input,
+    struct mathop_result * result,
+    int64_t * num_ops);
+
 /**
  * `mathop_error()` computes the error associated with the result
  * obtained after benchmarking a math operation.
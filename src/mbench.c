@@ -0,0 +1,374 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Public interface of the libmbench library.
+ */
+
+#include "mbench.h"
+#include "dispatch.h"
+#include "mathop.h"
+#include "round.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <errno.h>
+
+#include <fenv.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/* The backends are the ways of calling a function of `dispatch.h'. */
+_Static_assert((int) mbench_backend_direct == (int) dispatch_direct &&
+               (int) mbench_backend_pointer == (int) dispatch_pointer &&
+               (int) mbench_backend_plt == (int) dispatch_plt &&
+               (int) mbench_backend_inline == (int) dispatch_inline &&
+               (int) mbench_num_backends == (int) num_dispatches,
+               "mbench_backend must match enum dispatch");
+
+/**
+ * `mbench_backend_str()` is a string representing a given backend.
+ */
+const char * mbench_backend_str(
+    enum mbench_backend backend)
+{
+    if (backend == mbench_backend_auto)
+        return "auto";
+    return dispatch_str((enum dispatch) backend);
+}
+
+/**
+ * `mbench_num_ops()` is the number of math operations.
+ */
+int mbench_num_ops(void)
+{
+    return num_mathops;
+}
+
+/**
+ * `mbench_op_name()` is the name of a math operation, or `NULL' if
+ * there is no such operation.
+ */
+const char * mbench_op_name(
+    int op)
+{
+    if (op < 0 || op >= num_mathops)
+        return NULL;
+    return mathop_str(op);
+}
+
+/**
+ * `mbench_op_parse()` looks up a math operation by name.
+ */
+int mbench_op_parse(
+    const char * name,
+    int * op)
+{
+    enum mathop mathop;
+    int err = parse_mathop(name, &mathop);
+    if (err)
+        return err;
+    *op = mathop;
+    return 0;
+}
+
+/**
+ * `mbench_op_is_float()` is true if a math operation takes and
+ * returns `float', and false if it takes and returns `double'.
+ */
+int mbench_op_is_float(
+    int op)
+{
+    enum mathop_input_type input_type;
+    if (op < 0 || op >= num_mathops || mathop_input(op, &input_type))
+        return 0;
+    return input_type == mathop_input_f32;
+}
+
+/**
+ * `mbench_views()` describes caller-owned arrays as the input and
+ * result of a math operation, without copying them.
+ *
+ * Per-thread exception state is not used, since the number of
+ * threads that will evaluate the operation is not known.
+ */
+static int mbench_views(
+    int op,
+    int64_t n,
+    const void * x,
+    const void * y,
+    struct mathop_input * input,
+    struct mathop_result * result)
+{
+    if (op < 0 || op >= num_mathops || n < 0 || (n > 0 && (!x || !y)))
+        return EINVAL;
+    memset(input, 0, sizeof(*input));
+    memset(result, 0, sizeof(*result));
+    input->size = n;
+    result->size = n;
+    if (mbench_op_is_float(op)) {
+        input->type = mathop_input_f32;
+        input->f32 = (float *) x;
+        result->type = mathop_result_f32;
+        result->f32 = (float *) y;
+    } else {
+        input->type = mathop_input_f64;
+        input->f64 = (double *) x;
+        result->type = mathop_result_f64;
+        result->f64 = (double *) y;
+    }
+    return 0;
+}
+
+/**
+ * `mbench_eval_backend()` evaluates a math operation for `n` elements
+ * with a given backend.
+ */
+int mbench_eval_backend(
+    int op,
+    enum mbench_backend backend,
+    int64_t n,
+    const void * x,
+    void * y)
+{
+    if (backend == mbench_backend_auto)
+        return mbench_eval(op, n, x, y);
+    if (backend < 0 || backend >= mbench_num_backends)
+        return EINVAL;
+    struct mathop_input input;
+    struct mathop_result result;
+    int err = mbench_views(op, n, x, y, &input, &result);
+    if (err)
+        return err;
+    int64_t num_ops = 0;
+    return benchmark_dispatch(op, (enum dispatch) backend, &input, &result, &num_ops);
+}
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/*
+ * The backend chosen for each math operation, plus one, or zero if
+ * none has been chosen.
+ */
+static atomic_int mbench_selected[num_mathops];
+
+/**
+ * `mbench_fastest()` is the backend with the shortest time, or the
+ * direct calls if no backend could be timed.
+ */
+static int mbench_fastest(
+    const double * times)
+{
+    int best = mbench_backend_direct;
+    for (int b = 0; b < mbench_num_backends; b++) {
+        if (times[b] >= 0 && (times[best] < 0 || times[best] > times[b]))
+            best = b;
+    }
+    return best;
+}
+
+/**
+ * `in_parallel()` is true if called from within an active parallel
+ * region.
+ */
+static bool in_parallel(void)
+{
+#ifdef _OPENMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+}
+
+/**
+ * `mbench_select()` times every backend for a math operation on the
+ * given `n` elements of `x`, and chooses the fastest for subsequent
+ * calls to `mbench_eval()`.
+ *
+ * Domain and range errors do not disqualify a backend. The inlined
+ * builtins are not considered, since they do not report them. Within
+ * a parallel region, every thread times the backends together, and
+ * one thread chooses for the whole team.
+ */
+int mbench_select(
+    int op,
+    int64_t n,
+    const void * x,
+    void * y,
+    enum mbench_backend * backend)
+{
+    struct mathop_input input;
+    struct mathop_result result;
+    int err = mbench_views(op, n, x, y, &input, &result);
+    if (err)
+        return err;
+
+    double times[mbench_num_backends];
+    for (int b = 0; b < mbench_num_backends; b++) {
+        times[b] = -1.0;
+        if (b == mbench_backend_inline)
+            continue;
+        double samples[3];
+        err = mbench_time(op, b, n, x, y, 3, samples, NULL);
+        if (err && err != EDOM && err != ERANGE)
+            continue;
+        times[b] = samples[0];
+        for (int i = 1; i < 3; i++) {
+            if (times[b] > samples[i])
+                times[b] = samples[i];
+        }
+    }
+
+    int best = -1;
+    if (in_parallel()) {
+        #pragma omp single copyprivate(best)
+        best = mbench_fastest(times);
+    } else {
+        best = mbench_fastest(times);
+    }
+    atomic_store(&mbench_selected[op], best + 1);
+    if (backend)
+        *backend = best;
+    return mbench_eval_backend(op, best, n, x, y);
+}
+
+/**
+ * `mbench_eval()` evaluates a math operation for `n` elements, such
+ * that `y[i] = op(x[i])`.
+ *
+ * Within a parallel region, one thread reads the chosen backend for
+ * the whole team, so that every thread either selects a backend or
+ * evaluates with the same one.
+ */
+int mbench_eval(
+    int op,
+    int64_t n,
+    const void * x,
+    void * y)
+{
+    if (op < 0 || op >= num_mathops)
+        return EINVAL;
+    int selected;
+    if (in_parallel()) {
+        #pragma omp single copyprivate(selected)
+        selected = atomic_load(&mbench_selected[op]);
+    } else {
+        selected = atomic_load_explicit(&mbench_selected[op], memory_order_relaxed);
+    }
+    if (selected == 0)
+        return mbench_select(op, n, x, y, NULL);
+    return mbench_eval_backend(op, selected - 1, n, x, y);
+}
+
+/**
+ * `mbench_time()` evaluates a math operation `repeat` times for `n`
+ * elements with a given backend, and stores the time taken by each
+ * repetition, in seconds, in `samples`.
+ */
+int mbench_time(
+    int op,
+    enum mbench_backend backend,
+    int64_t n,
+    const void * x,
+    void * y,
+    int repeat,
+    double * samples,
+    int * excepts)
+{
+    if (op < 0 || op >= num_mathops || repeat < 0 || (repeat > 0 && !samples))
+        return EINVAL;
+    if (backend == mbench_backend_auto) {
+        int selected = atomic_load(&mbench_selected[op]);
+        backend = selected > 0 ? selected - 1 : mbench_backend_direct;
+    }
+
+    /*
+     * Collect the exceptions raised by the evaluations, and restore
+     * the exception flags of the caller afterwards.
+     */
+    fexcept_t saved;
+    fegetexceptflag(&saved, FE_ALL_EXCEPT);
+    feclearexcept(FE_ALL_EXCEPT);
+
+    /* Warm up caches before the measurement. */
+    int err = mbench_eval_backend(op, backend, n, x, y);
+    int flags = fetestexcept(FE_ALL_EXCEPT & ~FE_INEXACT);
+    for (int i = 0; i < repeat && (!err || err == EDOM || err == ERANGE); i++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        err = mbench_eval_backend(op, backend, n, x, y);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        samples[i] = timespec_duration(t0, t1);
+        flags |= fetestexcept(FE_ALL_EXCEPT & ~FE_INEXACT);
+    }
+    fesetexceptflag(&saved, FE_ALL_EXCEPT);
+    if (excepts)
+        *excepts = flags;
+    return err;
+}
+
+/**
+ * `mbench_error()` computes the maximum absolute and relative error of
+ * the results `y` of a math operation for the `n` elements of `x`.
+ */
+int mbench_error(
+    int op,
+    int64_t n,
+    const void * x,
+    const void * y,
+    int precision,
+    double * abs_error,
+    double * rel_error)
+{
+    struct mathop_input input;
+    struct mathop_result result;
+    int err = mbench_views(op, n, x, y, &input, &result);
+    if (err)
+        return err;
+    const char * exceptions;
+    return mathop_error(
+        op, &input, &result, round_tonearest, precision,
+        abs_error, rel_error, &exceptions);
+}
+
+/**
+ * `mbench_strerror()` is a description of an error number returned
+ * by the library.
+ */
+const char * mbench_strerror(
+    int err)
+{
+    if (err == ENOTSUP)
+        return "Operation not supported (libmbench was built without MPFR)";
+    return strerror(err);
+}
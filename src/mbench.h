@@ -0,0 +1,194 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Public interface of the libmbench library.
+ */
+
+#ifndef MBENCH_H
+#define MBENCH_H
+
+#include <stdint.h>
+
+/*
+ * Only the functions declared here are exported from the shared
+ * library, which is compiled with `-fvisibility=hidden'.
+ */
+#define MBENCH_API __attribute__((visibility("default")))
+
+/*
+ * The libmbench library evaluates, times and checks the accuracy of
+ * the functions from the C math library that are benchmarked by the
+ * `mbench' program. Math operations are identified by integers from
+ * `0' to `mbench_num_ops() - 1', which may be looked up by name, such
+ * as `exp' or `sqrtf'. Operations whose names end in `f' take and
+ * return `float', and the others take and return `double'.
+ *
+ * Functions that may fail return `0' on success or an error number
+ * from <errno.h>, which is described by `mbench_strerror()'.
+ *
+ * Evaluation uses the same OpenMP worksharing loops as the `mbench'
+ * program. If a function is called from within a parallel region,
+ * then every thread of the team must call it with the same arguments,
+ * and the elements are shared among the threads.
+ */
+
+/**
+ * `mbench_backend` is used to enumerate different ways of calling a
+ * math function.
+ */
+enum mbench_backend
+{
+    mbench_backend_auto = -1,   /* the fastest backend with errno, chosen on first use */
+    mbench_backend_direct = 0,  /* direct calls, as compiled */
+    mbench_backend_pointer,     /* calls through a function pointer */
+    mbench_backend_plt,         /* calls to the library symbol through the PLT */
+    mbench_backend_inline,      /* inlined builtins that do not set errno */
+
+    /* A final dummy entry, equal to the number of backends. */
+    mbench_num_backends
+};
+
+/**
+ * `mbench_backend_str()` is a string representing a given backend.
+ */
+MBENCH_API const char * mbench_backend_str(
+    enum mbench_backend backend);
+
+/**
+ * `mbench_num_ops()` is the number of math operations.
+ */
+MBENCH_API int mbench_num_ops(void);
+
+/**
+ * `mbench_op_name()` is the name of a math operation, or `NULL' if
+ * there is no such operation.
+ */
+MBENCH_API const char * mbench_op_name(
+    int op);
+
+/**
+ * `mbench_op_parse()` looks up a math operation by name.
+ *
+ * On success, `mbench_op_parse()` returns `0`. If there is no math
+ * operation with the given name, then `mbench_op_parse()` returns
+ * `EINVAL`.
+ */
+MBENCH_API int mbench_op_parse(
+    const char * name,
+    int * op);
+
+/**
+ * `mbench_op_is_float()` is true if a math operation takes and
+ * returns `float', and false if it takes and returns `double'.
+ */
+MBENCH_API int mbench_op_is_float(
+    int op);
+
+/**
+ * `mbench_select()` times every backend for a math operation on the
+ * given `n` elements of `x`, and chooses the fastest for subsequent
+ * calls to `mbench_eval()`.
+ *
+ * The results are stored in `y`, as for `mbench_eval()`. If `backend`
+ * is not `NULL', the chosen backend is stored in it. The choice is
+ * recorded separately for each math operation and may be made
+ * concurrently from different threads. Within a parallel region, the
+ * same backend is chosen for every thread of the team.
+ *
+ * The inlined builtins are never chosen, since they do not set
+ * `errno'. A caller that does not need domain and range errors may
+ * use them with `mbench_eval_backend()' and `mbench_backend_inline'.
+ */
+MBENCH_API int mbench_select(
+    int op,
+    int64_t n,
+    const void * x,
+    void * y,
+    enum mbench_backend * backend);
+
+/**
+ * `mbench_eval()` evaluates a math operation for `n` elements, such
+ * that `y[i] = op(x[i])`.
+ *
+ * The backend chosen by `mbench_select()` is used. If none has been
+ * chosen for the math operation, then `mbench_select()` is called
+ * first with the given elements.
+ */
+MBENCH_API int mbench_eval(
+    int op,
+    int64_t n,
+    const void * x,
+    void * y);
+
+/**
+ * `mbench_eval_backend()` evaluates a math operation for `n` elements
+ * with a given backend.
+ */
+MBENCH_API int mbench_eval_backend(
+    int op,
+    enum mbench_backend backend,
+    int64_t n,
+    const void * x,
+    void * y);
+
+/**
+ * `mbench_time()` evaluates a math operation `repeat` times for `n`
+ * elements with a given backend, and stores the time taken by each
+ * repetition, in seconds, in `samples`.
+ *
+ * The first evaluation is not timed, so that caches are warm, and the
+ * floating-point exceptions raised by the evaluations are stored in
+ * `excepts`, if it is not `NULL'.
+ */
+MBENCH_API int mbench_time(
+    int op,
+    enum mbench_backend backend,
+    int64_t n,
+    const void * x,
+    void * y,
+    int repeat,
+    double * samples,
+    int * excepts);
+
+/**
+ * `mbench_error()` computes the maximum absolute and relative error of
+ * the results `y` of a math operation for the `n` elements of `x`, by
+ * comparing with a reference computed by the GNU MPFR library with
+ * `precision` bits and rounding to nearest.
+ *
+ * If the library was built without support for MPFR, then
+ * `mbench_error()` returns `ENOTSUP`.
+ */
+MBENCH_API int mbench_error(
+    int op,
+    int64_t n,
+    const void * x,
+    const void * y,
+    int precision,
+    double * abs_error,
+    double * rel_error);
+
+/**
+ * `mbench_strerror()` is a description of an error number returned
+ * by the library.
+ */
+MBENCH_API const char * mbench_strerror(
+    int err);
+
+#endif
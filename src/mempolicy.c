@@ -0,0 +1,190 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * NUMA memory placement policies.
+ */
+
+#include "mempolicy.h"
+
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * The number of bits in the node masks passed to the kernel, which
+ * must be at least the number of possible nodes in the system.
+ */
+#define MEMPOLICY_MASK_BITS 1024
+#define MEMPOLICY_MASK_WORDS \
+    (MEMPOLICY_MASK_BITS / (CHAR_BIT * sizeof(unsigned long)))
+
+/**
+ * `mempolicy_str()` is a string representing a given memory policy.
+ */
+const char * mempolicy_str(
+    enum mempolicy mempolicy)
+{
+    switch (mempolicy) {
+    case mempolicy_default: return "default";
+    case mempolicy_firsttouch: return "firsttouch";
+    case mempolicy_interleave: return "interleave";
+    case mempolicy_local: return "local";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `parse_mempolicy()` parses a string designating a memory policy.
+ *
+ * On success, `parse_mempolicy()` returns `0`. If the string does
+ * not correspond to a valid memory policy, then `parse_mempolicy()`
+ * returns `EINVAL`.
+ */
+int parse_mempolicy(
+    const char * s,
+    enum mempolicy * mempolicy)
+{
+    if (strcmp(s, "default") == 0) {
+        *mempolicy = mempolicy_default;
+    } else if (strcmp(s, "firsttouch") == 0) {
+        *mempolicy = mempolicy_firsttouch;
+    } else if (strcmp(s, "interleave") == 0) {
+        *mempolicy = mempolicy_interleave;
+    } else if (strcmp(s, "local") == 0) {
+        *mempolicy = mempolicy_local;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `mempolicy_bind()` applies a memory policy to a range of memory
+ * before it is first touched.
+ */
+int mempolicy_bind(
+    void * p,
+    size_t size,
+    enum mempolicy mempolicy)
+{
+    unsigned long nodemask[MEMPOLICY_MASK_WORDS];
+    memset(nodemask, 0, sizeof(nodemask));
+    int mode;
+
+    switch (mempolicy) {
+    case mempolicy_default:
+    case mempolicy_firsttouch:
+        return 0;
+
+    case mempolicy_interleave:
+        /* Interleave across every node the process may use. */
+        if (syscall(SYS_get_mempolicy, NULL, nodemask,
+                    MEMPOLICY_MASK_BITS, NULL, MPOL_F_MEMS_ALLOWED))
+            return errno;
+        mode = MPOL_INTERLEAVE;
+        break;
+
+    case mempolicy_local:
+        {
+            /* Prefer the node on which the calling thread runs. */
+            unsigned int cpu, node;
+            if (syscall(SYS_getcpu, &cpu, &node, NULL))
+                return errno;
+            if (node >= MEMPOLICY_MASK_BITS)
+                return ERANGE;
+            nodemask[node / (CHAR_BIT * sizeof(unsigned long))] |=
+                1UL << (node % (CHAR_BIT * sizeof(unsigned long)));
+            mode = MPOL_PREFERRED;
+        }
+        break;
+
+    default:
+        return EINVAL;
+    }
+
+    if (size == 0)
+        return 0;
+    /* Pages that were touched earlier are migrated, if possible. */
+    if (syscall(SYS_mbind, p, size, mode, nodemask,
+                MEMPOLICY_MASK_BITS, MPOL_MF_MOVE))
+        return errno;
+    return 0;
+}
+
+/**
+ * `mempolicy_placement()` finds the NUMA node of each page in a range
+ * of memory.
+ */
+int mempolicy_placement(
+    const void * p,
+    size_t size,
+    struct mempolicy_placement * placement)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t) p) & ~((uintptr_t) page_size - 1);
+    uintptr_t end = (uintptr_t) p + size;
+
+    memset(placement, 0, sizeof(*placement));
+    enum { batch_size = 1024 };
+    void * pages[batch_size];
+    int status[batch_size];
+    for (uintptr_t addr = begin; addr < end; ) {
+        unsigned long count = 0;
+        for (; count < batch_size && addr < end; count++, addr += page_size)
+            pages[count] = (void *) addr;
+        if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0))
+            return errno;
+        for (unsigned long i = 0; i < count; i++) {
+            if (status[i] < 0 || status[i] >= MEMPOLICY_MAX_NODES) {
+                placement->pages_not_present++;
+            } else {
+                placement->pages[status[i]]++;
+                if (status[i] + 1 > placement->num_nodes)
+                    placement->num_nodes = status[i] + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * `mempolicy_placement_print()` prints the number of pages on each
+ * NUMA node.
+ */
+void mempolicy_placement_print(
+    const struct mempolicy_placement * placement,
+    FILE * f)
+{
+    for (int node = 0; node < placement->num_nodes; node++) {
+        fprintf(f, "%snode%d: %"PRId64" pages",
+                node > 0 ? " " : "", node, placement->pages[node]);
+    }
+    if (placement->pages_not_present > 0) {
+        fprintf(f, "%snot present: %"PRId64" pages",
+                placement->num_nodes > 0 ? " " : "",
+                placement->pages_not_present);
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * NUMA memory placement policies.
+ */
+
+#ifndef MEMPOLICY_H
+#define MEMPOLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `mempolicy` is used to enumerate different policies for placing
+ * memory pages on NUMA nodes.
+ */
+enum mempolicy
+{
+    mempolicy_default = 0, /* leave placement to the operating system */
+    mempolicy_firsttouch,  /* first touch by the thread using a page */
+    mempolicy_interleave,  /* interleave pages across all nodes */
+    mempolicy_local,       /* place pages on the node of the main thread */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_mempolicies
+};
+
+/**
+ * `mempolicy_str()` is a string representing a given memory policy.
+ */
+const char * mempolicy_str(
+    enum mempolicy mempolicy);
+
+/**
+ * `parse_mempolicy()` parses a string designating a memory policy.
+ *
+ * On success, `parse_mempolicy()` returns `0`. If the string does
+ * not correspond to a valid memory policy, then `parse_mempolicy()`
+ * returns `EINVAL`.
+ */
+int parse_mempolicy(
+    const char * s,
+    enum mempolicy * mempolicy);
+
+/**
+ * `mempolicy_bind()` applies a memory policy to a range of memory
+ * before it is first touched.
+ *
+ * The address `p` must be aligned to the page size. For the default
+ * and first-touch policies, the memory is left alone, and pages are
+ * placed on the node of the thread that first touches them.
+ */
+int mempolicy_bind(
+    void * p,
+    size_t size,
+    enum mempolicy mempolicy);
+
+/**
+ * `MEMPOLICY_MAX_NODES` is the largest number of NUMA nodes for
+ * which memory placement is reported.
+ */
+#define MEMPOLICY_MAX_NODES 64
+
+/**
+ * `mempolicy_placement` records the number of pages of a range of
+ * memory that reside on each NUMA node.
+ */
+struct mempolicy_placement
+{
+    int num_nodes;
+    int64_t pages[MEMPOLICY_MAX_NODES];
+    int64_t pages_not_present;
+};
+
+/**
+ * `mempolicy_placement()` finds the NUMA node of each page in a range
+ * of memory.
+ */
+int mempolicy_placement(
+    const void * p,
+    size_t size,
+    struct mempolicy_placement * placement);
+
+/**
+ * `mempolicy_placement_print()` prints the number of pages on each
+ * NUMA node.
+ */
+void mempolicy_placement_print(
+    const struct mempolicy_placement * placement,
+    FILE * f);
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Time series of throughput, clock frequency and temperature.
+ */
+
+#define _GNU_SOURCE
+
+#include "monitor.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * `monitor_format_str()` is a string representing a given output
+ * format for time series.
+ */
+const char * monitor_format_str(
+    enum monitor_format monitor_format)
+{
+    switch (monitor_format) {
+    case monitor_csv: return "csv";
+    case monitor_json: return "json";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `parse_monitor_format()` parses a string designating an output
+ * format for time series.
+ */
+int parse_monitor_format(
+    const char * s,
+    enum monitor_format * monitor_format)
+{
+    if (strcmp(s, "csv") == 0) {
+        *monitor_format = monitor_csv;
+    } else if (strcmp(s, "json") == 0) {
+        *monitor_format = monitor_json;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `read_long()` reads an integer from a file in sysfs.
+ */
+static int read_long(
+    const char * path,
+    long * value)
+{
+    FILE * f = fopen(path, "r");
+    if (!f)
+        return errno;
+    if (fscanf(f, "%ld", value) != 1) {
+        int err = ferror(f) ? errno : EINVAL;
+        fclose(f);
+        return err;
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * `cpu_frequency()` is the current clock frequency of a CPU in MHz,
+ * or a negative value if it is not known.
+ */
+static double cpu_frequency(
+    int cpu)
+{
+    char path[128];
+    long khz;
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+    if (cpu < 0 || read_long(path, &khz))
+        return -1.0;
+    return khz * 1e-3;
+}
+
+/**
+ * `max_temperature()` is the highest temperature, in degrees
+ * Celsius, of the thermal zones in `/sys/class/thermal', or a
+ * negative value if it is not known.
+ */
+static double max_temperature(void)
+{
+    DIR * dir = opendir("/sys/class/thermal");
+    if (!dir)
+        return -1.0;
+    long max_millidegrees = -1000;
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "thermal_zone", strlen("thermal_zone")) != 0)
+            continue;
+        char path[320];
+        long millidegrees;
+        snprintf(path, sizeof(path), "/sys/class/thermal/%s/temp", entry->d_name);
+        if (!read_long(path, &millidegrees) && max_millidegrees < millidegrees)
+            max_millidegrees = millidegrees;
+    }
+    closedir(dir);
+    return max_millidegrees * 1e-3;
+}
+
+/**
+ * `monitor_sample()` writes a sample to the output stream.
+ */
+static void monitor_sample(
+    struct monitor * monitor,
+    double * prev_time,
+    int64_t * prev_num_ops)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    double time = timespec_duration(monitor->t0, t);
+    int64_t num_ops = atomic_load_explicit(&monitor->num_ops, memory_order_relaxed);
+    int cpu = atomic_load_explicit(&monitor->cpu, memory_order_relaxed);
+    double mops = time > *prev_time
+        ? (num_ops - *prev_num_ops) / (time - *prev_time) * 1e-6 : 0.0;
+    double frequency = cpu_frequency(cpu);
+    double temperature = max_temperature();
+    *prev_time = time;
+    *prev_num_ops = num_ops;
+
+    FILE * f = monitor->f;
+    if (monitor->format == monitor_csv) {
+        fprintf(f, "%.6f,%"PRId64",%.6f,%d,", time, num_ops, mops, cpu);
+        if (frequency >= 0)
+            fprintf(f, "%.0f", frequency);
+        fputc(',', f);
+        if (temperature > -1.0)
+            fprintf(f, "%.1f", temperature);
+        fputc('\n', f);
+    } else if (monitor->format == monitor_json) {
+        fprintf(f, "%s\n  {\"time\": %.6f, \"ops\": %"PRId64", \"mops\": %.6f, "
+                "\"cpu\": %d, ", monitor->num_samples > 0 ? "," : "",
+                time, num_ops, mops, cpu);
+        if (frequency >= 0)
+            fprintf(f, "\"freq_mhz\": %.0f, ", frequency);
+        else
+            fprintf(f, "\"freq_mhz\": null, ");
+        if (temperature > -1.0)
+            fprintf(f, "\"temp_c\": %.1f}", temperature);
+        else
+            fprintf(f, "\"temp_c\": null}");
+    }
+    fflush(f);
+    monitor->num_samples++;
+}
+
+/**
+ * `monitor_main()` writes samples at a fixed interval until the
+ * monitor is stopped.
+ */
+static void * monitor_main(
+    void * arg)
+{
+    struct monitor * monitor = arg;
+    double prev_time = 0.0;
+    int64_t prev_num_ops = 0;
+    struct timespec next = monitor->t0;
+    pthread_mutex_lock(&monitor->mutex);
+    while (!monitor->stop) {
+        /*
+         * Sleep until the next sample is due, or until the monitor is
+         * stopped, without waking up in between.
+         */
+        double interval = monitor->interval;
+        next.tv_sec += (time_t) interval;
+        next.tv_nsec += (long) ((interval - (time_t) interval) * 1e9);
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        while (!monitor->stop &&
+               pthread_cond_timedwait(&monitor->cond, &monitor->mutex, &next) != ETIMEDOUT)
+            ;
+        if (monitor->stop)
+            break;
+        pthread_mutex_unlock(&monitor->mutex);
+        monitor_sample(monitor, &prev_time, &prev_num_ops);
+        pthread_mutex_lock(&monitor->mutex);
+    }
+    pthread_mutex_unlock(&monitor->mutex);
+    monitor_sample(monitor, &prev_time, &prev_num_ops);
+    return NULL;
+}
+
+/**
+ * `monitor_start()` starts a thread that writes a sample to the
+ * given stream every `interval` seconds.
+ */
+int monitor_start(
+    struct monitor * monitor,
+    FILE * f,
+    enum monitor_format format,
+    double interval)
+{
+    if (!(interval > 0))
+        return EINVAL;
+    monitor->f = f;
+    monitor->format = format;
+    monitor->interval = interval;
+    monitor->num_samples = 0;
+    monitor->stop = false;
+    atomic_init(&monitor->num_ops, 0);
+    atomic_init(&monitor->cpu, sched_getcpu());
+
+    /* The condition variable waits on the monotonic clock. */
+    pthread_condattr_t attr;
+    int err = pthread_condattr_init(&attr);
+    if (err)
+        return err;
+    err = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (!err)
+        err = pthread_cond_init(&monitor->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (err)
+        return err;
+    err = pthread_mutex_init(&monitor->mutex, NULL);
+    if (err) {
+        pthread_cond_destroy(&monitor->cond);
+        return err;
+    }
+
+    if (format == monitor_csv)
+        fprintf(f, "time,ops,mops,cpu,freq_mhz,temp_c\n");
+    else if (format == monitor_json)
+        fprintf(f, "[");
+    clock_gettime(CLOCK_MONOTONIC, &monitor->t0);
+    err = pthread_create(&monitor->thread, NULL, monitor_main, monitor);
+    if (err) {
+        pthread_mutex_destroy(&monitor->mutex);
+        pthread_cond_destroy(&monitor->cond);
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `monitor_progress()` reports the cumulative number of operations
+ * performed so far.
+ */
+void monitor_progress(
+    struct monitor * monitor,
+    int64_t num_ops)
+{
+    atomic_store_explicit(&monitor->num_ops, num_ops, memory_order_relaxed);
+    atomic_store_explicit(&monitor->cpu, sched_getcpu(), memory_order_relaxed);
+}
+
+/**
+ * `monitor_stop()` writes a final sample and stops the monitor.
+ */
+int monitor_stop(
+    struct monitor * monitor)
+{
+    pthread_mutex_lock(&monitor->mutex);
+    monitor->stop = true;
+    pthread_cond_signal(&monitor->cond);
+    pthread_mutex_unlock(&monitor->mutex);
+    int err = pthread_join(monitor->thread, NULL);
+    pthread_mutex_destroy(&monitor->mutex);
+    pthread_cond_destroy(&monitor->cond);
+    if (monitor->format == monitor_json)
+        fprintf(monitor->f, "\n]\n");
+    if (fflush(monitor->f) && !err)
+        err = errno;
+    if (ferror(monitor->f) && !err)
+        err = EIO;
+    return err;
+}
@@ -0,0 +1,116 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Time series of throughput, clock frequency and temperature.
+ */
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <pthread.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * `monitor_format` is used to enumerate output formats for time
+ * series.
+ */
+enum monitor_format
+{
+    monitor_csv = 0, /* comma-separated values with a header line */
+    monitor_json,    /* an array of JSON objects */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_monitor_formats
+};
+
+/**
+ * `monitor_format_str()` is a string representing a given output
+ * format for time series.
+ */
+const char * monitor_format_str(
+    enum monitor_format monitor_format);
+
+/**
+ * `parse_monitor_format()` parses a string designating an output
+ * format for time series.
+ *
+ * On success, `parse_monitor_format()` returns `0`. If the string
+ * does not correspond to a valid output format, then
+ * `parse_monitor_format()` returns `EINVAL`.
+ */
+int parse_monitor_format(
+    const char * s,
+    enum monitor_format * monitor_format);
+
+/**
+ * `monitor` is a thread that periodically samples the progress of a
+ * benchmark.
+ */
+struct monitor
+{
+    FILE * f;
+    enum monitor_format format;
+    double interval;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct timespec t0;
+    bool stop;
+    _Atomic int64_t num_ops;
+    atomic_int cpu;
+    int num_samples;
+};
+
+/**
+ * `monitor_start()` starts a thread that writes a sample to the
+ * given stream every `interval` seconds.
+ *
+ * Each sample consists of the time since the start, the cumulative
+ * number of operations, the throughput since the previous sample, and
+ * the current clock frequency and the highest temperature reported by
+ * `/sys/class/thermal', if available. The clock frequency is that of
+ * the CPU on which progress was last reported.
+ */
+int monitor_start(
+    struct monitor * monitor,
+    FILE * f,
+    enum monitor_format format,
+    double interval);
+
+/**
+ * `monitor_progress()` reports the cumulative number of operations
+ * performed so far. This is cheap enough to be called once per
+ * repetition of the benchmark from one of its threads.
+ */
+void monitor_progress(
+    struct monitor * monitor,
+    int64_t num_ops);
+
+/**
+ * `monitor_stop()` writes a final sample and stops the monitor.
+ */
+int monitor_stop(
+    struct monitor * monitor);
+
+#endif
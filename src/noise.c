@@ -0,0 +1,393 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Background load generators that interfere with the benchmark.
+ */
+
+#define _GNU_SOURCE
+
+#include "noise.h"
+#include "fma.h"
+#include "topology.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * `noise_type_str()` is a string representing a given kind of
+ * background load.
+ */
+const char * noise_type_str(
+    enum noise_type noise_type)
+{
+    switch (noise_type) {
+    case noise_stream: return "stream";
+    case noise_chase: return "chase";
+    case noise_fma: return "fma";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `parse_noise_type()` parses a string designating a kind of
+ * background load.
+ */
+int parse_noise_type(
+    const char * s,
+    enum noise_type * noise_type)
+{
+    if (strcmp(s, "stream") == 0) {
+        *noise_type = noise_stream;
+    } else if (strcmp(s, "chase") == 0) {
+        *noise_type = noise_chase;
+    } else if (strcmp(s, "fma") == 0) {
+        *noise_type = noise_fma;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * `parse_noise_types()` parses a comma-separated list of kinds of
+ * background load, such as `stream,chase,fma'.
+ */
+int parse_noise_types(
+    const char * s,
+    struct noise_types * noise_types)
+{
+    char buf[64];
+    noise_types->num_types = 0;
+    while (true) {
+        size_t len = strcspn(s, ",");
+        if (len == 0 || len >= sizeof(buf) ||
+            noise_types->num_types >= num_noise_types)
+            return EINVAL;
+        memcpy(buf, s, len);
+        buf[len] = '\0';
+        int err = parse_noise_type(
+            buf, &noise_types->types[noise_types->num_types]);
+        if (err)
+            return err;
+        noise_types->num_types++;
+        if (s[len] == '\0')
+            break;
+        s += len+1;
+    }
+    return 0;
+}
+
+/**
+ * `noise_thread` is the state of a thread that generates background
+ * load on one CPU.
+ */
+struct noise_thread
+{
+    struct noise * noise;
+    int cpu;
+    pthread_t id;
+    double work;
+    double seconds;
+    double sink;
+    int err;
+};
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `noise_ready()` records the outcome of setting up a thread and then
+ * signals that the thread is ready, so that `noise_start()` sees the
+ * error of every thread that it has counted as ready. The error is not
+ * changed afterwards.
+ */
+static void noise_ready(
+    struct noise_thread * thread,
+    int err)
+{
+    thread->err = err;
+    atomic_fetch_add(&thread->noise->num_ready, 1);
+}
+
+/**
+ * `noise_stream_main()` performs a STREAM triad, `a[i] = b[i] + s*c[i]`,
+ * over arrays that are four times larger than the last-level cache,
+ * until it is told to stop.
+ */
+static void noise_stream_main(
+    struct noise_thread * thread)
+{
+    size_t n = 4 * topology_llc_size() / (3 * sizeof(double));
+    double * a = malloc(n * sizeof(double));
+    double * b = malloc(n * sizeof(double));
+    double * c = malloc(n * sizeof(double));
+    if (!a || !b || !c) {
+        int err = errno;
+        free(c); free(b); free(a);
+        noise_ready(thread, err);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    noise_ready(thread, 0);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int64_t sweeps = 0;
+    while (!atomic_load_explicit(&thread->noise->stop, memory_order_relaxed)) {
+        for (size_t i = 0; i < n; i++)
+            a[i] = b[i] + 3.0 * c[i];
+        sweeps++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    thread->seconds = timespec_duration(t0, t1);
+    thread->work = (double) sweeps * n * 3 * sizeof(double);
+    thread->sink = a[n-1];
+    free(c); free(b); free(a);
+}
+
+/**
+ * `noise_chase_main()` follows a random cyclic chain of pointers,
+ * one per cache line, through a buffer of the same size as the
+ * last-level cache, until it is told to stop.
+ */
+static void noise_chase_main(
+    struct noise_thread * thread)
+{
+    const size_t line_size = 64;
+    size_t n = topology_llc_size() / line_size;
+    char * buf = malloc(n * line_size);
+    size_t * order = malloc(n * sizeof(size_t));
+    if (!buf || !order) {
+        int err = errno;
+        free(order); free(buf);
+        noise_ready(thread, err);
+        return;
+    }
+
+    /* Sattolo's algorithm yields a single cycle through all lines. */
+    uint64_t state = 0x9e3779b97f4a7c15ull ^ thread->cpu;
+    for (size_t i = 0; i < n; i++)
+        order[i] = i;
+    for (size_t i = n-1; i > 0; i--) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        size_t j = state % i;
+        size_t tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+    }
+    for (size_t i = 0; i < n; i++)
+        *(void **) &buf[order[i] * line_size] = &buf[order[(i+1) % n] * line_size];
+    free(order);
+    noise_ready(thread, 0);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int64_t loads = 0;
+    void ** p = (void **) buf;
+    while (!atomic_load_explicit(&thread->noise->stop, memory_order_relaxed)) {
+        for (int i = 0; i < 65536; i++)
+            p = (void **) *p;
+        loads += 65536;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    thread->seconds = timespec_duration(t0, t1);
+    thread->work = loads;
+    thread->sink = (double) (uintptr_t) p;
+    free(buf);
+}
+
+/**
+ * `noise_fma_main()` performs independent vector fused multiply-adds,
+ * using the widest vectors supported by the CPU, until it is told to
+ * stop.
+ */
+static void noise_fma_main(
+    struct noise_thread * thread)
+{
+    noise_ready(thread, 0);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int64_t iterations = 0;
+    while (!atomic_load_explicit(&thread->noise->stop, memory_order_relaxed)) {
+        thread->sink += fma_kernel(65536);
+        iterations += 65536;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    thread->seconds = timespec_duration(t0, t1);
+    thread->work = (double) iterations * fma_flops_per_iteration();
+}
+
+/**
+ * `noise_thread_main()` binds the calling thread to its CPU and
+ * generates background load until it is told to stop.
+ */
+static void * noise_thread_main(
+    void * arg)
+{
+    struct noise_thread * thread = arg;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(thread->cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set)) {
+        noise_ready(thread, errno);
+        return NULL;
+    }
+
+    switch (thread->noise->type) {
+    case noise_stream:
+        noise_stream_main(thread);
+        break;
+    case noise_chase:
+        noise_chase_main(thread);
+        break;
+    case noise_fma:
+        noise_fma_main(thread);
+        break;
+    default:
+        noise_ready(thread, EINVAL);
+        break;
+    }
+    return NULL;
+}
+
+/**
+ * `noise_join()` stops and joins the first `num_threads` threads of a
+ * background load, and frees the threads.
+ */
+static int noise_join(
+    struct noise * noise,
+    int num_threads)
+{
+    int err = 0;
+    atomic_store(&noise->stop, 1);
+    noise->rate = 0.0;
+    for (int i = 0; i < num_threads; i++) {
+        struct noise_thread * thread = &noise->threads[i];
+        pthread_join(thread->id, NULL);
+        if (!err)
+            err = thread->err;
+        if (thread->seconds > 0)
+            noise->rate += thread->work / thread->seconds;
+    }
+    free(noise->threads);
+    noise->threads = NULL;
+    return err;
+}
+
+/**
+ * `noise_start()` starts a background load on each of the given
+ * CPUs.
+ */
+int noise_start(
+    struct noise * noise,
+    enum noise_type type,
+    int num_cpus,
+    const int * cpus)
+{
+    for (int i = 0; i < num_cpus; i++) {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+            return EINVAL;
+    }
+    noise->type = type;
+    noise->num_threads = num_cpus;
+    noise->kernel = type == noise_fma ? fma_kernel_name() : NULL;
+    noise->rate = 0.0;
+    atomic_init(&noise->num_ready, 0);
+    atomic_init(&noise->stop, 0);
+    noise->threads = calloc(num_cpus, sizeof(struct noise_thread));
+    if (!noise->threads)
+        return errno;
+
+    for (int i = 0; i < num_cpus; i++) {
+        struct noise_thread * thread = &noise->threads[i];
+        thread->noise = noise;
+        thread->cpu = cpus[i];
+        int err = pthread_create(&thread->id, NULL, noise_thread_main, thread);
+        if (err) {
+            noise_join(noise, i);
+            return err;
+        }
+    }
+
+    /* Wait until every thread has set up its buffers. */
+    while (atomic_load(&noise->num_ready) < num_cpus)
+        sched_yield();
+    for (int i = 0; i < num_cpus; i++) {
+        int err = noise->threads[i].err;
+        if (err) {
+            noise_join(noise, num_cpus);
+            return err;
+        }
+    }
+    return 0;
+}
+
+/**
+ * `noise_stop()` stops a background load and records the rate at
+ * which its threads performed work, summed over all threads.
+ */
+int noise_stop(
+    struct noise * noise)
+{
+    return noise_join(noise, noise->num_threads);
+}
+
+/**
+ * `noise_print()` prints the rate at which a background load
+ * generated work.
+ */
+void noise_print(
+    const struct noise * noise,
+    FILE * f)
+{
+    switch (noise->type) {
+    case noise_stream:
+        fprintf(f, "%.3f GB/s", noise->rate * 1e-9);
+        break;
+    case noise_chase:
+        fprintf(f, "%.3f Mloads/s %.1f ns/load", noise->rate * 1e-6,
+                noise->rate > 0 ? 1e9 * noise->num_threads / noise->rate : 0.0);
+        break;
+    case noise_fma:
+        fprintf(f, "%.3f Gflop/s (%s)", noise->rate * 1e-9, noise->kernel);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Background load generators that interfere with the benchmark.
+ */
+
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+/**
+ * `noise_type` is used to enumerate different kinds of background
+ * load.
+ */
+enum noise_type
+{
+    noise_stream = 0, /* STREAM-like triad over arrays larger than the LLC */
+    noise_chase,      /* dependent loads chasing pointers through the LLC */
+    noise_fma,        /* independent vector FMAs, using AVX-512 if available */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_noise_types
+};
+
+/**
+ * `noise_type_str()` is a string representing a given kind of
+ * background load.
+ */
+const char * noise_type_str(
+    enum noise_type noise_type);
+
+/**
+ * `parse_noise_type()` parses a string designating a kind of
+ * background load.
+ *
+ * On success, `parse_noise_type()` returns `0`. If the string does
+ * not correspond to a valid kind of background load, then
+ * `parse_noise_type()` returns `EINVAL`.
+ */
+int parse_noise_type(
+    const char * s,
+    enum noise_type * noise_type);
+
+/**
+ * `noise_types` is a list of kinds of background load.
+ */
+struct noise_types
+{
+    int num_types;
+    enum noise_type types[num_noise_types];
+};
+
+/**
+ * `parse_noise_types()` parses a comma-separated list of kinds of
+ * background load, such as `stream,chase,fma'.
+ */
+int parse_noise_types(
+    const char * s,
+    struct noise_types * noise_types);
+
+struct noise_thread;
+
+/**
+ * `noise` is a background load that runs in one thread per CPU.
+ */
+struct noise
+{
+    enum noise_type type;
+    int num_threads;
+    struct noise_thread * threads;
+    atomic_int num_ready;
+    atomic_int stop;
+    const char * kernel;
+    double rate;
+};
+
+/**
+ * `noise_start()` starts a background load on each of the given
+ * CPUs.
+ *
+ * Each thread is bound to its CPU and allocates its own buffers.
+ * `noise_start()` returns once every thread has finished setting up
+ * and started generating load.
+ */
+int noise_start(
+    struct noise * noise,
+    enum noise_type type,
+    int num_cpus,
+    const int * cpus);
+
+/**
+ * `noise_stop()` stops a background load and records the rate at
+ * which its threads performed work, summed over all threads.
+ */
+int noise_stop(
+    struct noise * noise);
+
+/**
+ * `noise_print()` prints the rate at which a background load
+ * generated work: bytes per second for `stream', loads per second and
+ * latency per load for `chase', and floating-point operations per
+ * second for `fma'.
+ */
+void noise_print(
+    const struct noise * noise,
+    FILE * f);
+
+#endif
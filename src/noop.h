@@ -0,0 +1,45 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Opaque functions that return their argument unchanged.
+ */
+
+#ifndef NOOP_H
+#define NOOP_H
+
+/**
+ * `noop()` returns its argument unchanged.
+ *
+ * `noop()` has the same signature as the double-precision math
+ * functions, and it is defined in its own translation unit, so that
+ * calls to it cannot be inlined. It is used to measure the cost of
+ * calling a math function, as opposed to computing it.
+ */
+double noop(
+    double x);
+
+/**
+ * `noopf()` returns its argument unchanged.
+ *
+ * `noopf()` is the single-precision counterpart of `noop()`.
+ */
+float noopf(
+    float x);
+
+#endif
@@ -0,0 +1,338 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Microbenchmarks for the overhead of OpenMP synchronisation and
+ * scheduling constructs, following the methodology of the EPCC
+ * OpenMP microbenchmarks.
+ */
+
+#include "ompbench.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <errno.h>
+
+#include <stdio.h>
+
+#ifdef _OPENMP
+
+/*
+ * The same reduction operator that is used to combine errors from
+ * different threads in `main()'.
+ */
+#pragma omp declare reduction(                                          \
+    err_add : int :                                                     \
+    omp_out = omp_out ? omp_out : omp_in)                               \
+    initializer (omp_priv=0)
+
+/**
+ * `delay()` performs a fixed amount of work that the compiler cannot
+ * optimise away.
+ */
+static void delay(
+    int delay_length)
+{
+    volatile double a = 0.0;
+    for (int i = 0; i < delay_length; i++)
+        a += i;
+}
+
+/**
+ * `delay_length()` calibrates the delay loop so that a single call
+ * to `delay()` takes roughly the given time.
+ */
+static int delay_length(
+    double delay_time)
+{
+    int length = 1000;
+    int reps = 1000;
+    double t0 = omp_get_wtime();
+    for (int j = 0; j < reps; j++)
+        delay(length);
+    double t1 = omp_get_wtime();
+    double time_per_delay = (t1 - t0) / reps;
+    if (time_per_delay <= 0)
+        return length;
+    length = (int) (length * delay_time / time_per_delay);
+    return length > 0 ? length : 1;
+}
+
+/*
+ * The following functions measure the time taken to execute an OpenMP
+ * construct `inner_reps` times around the delay loop. `reference()`
+ * measures the time taken by the delay loop alone.
+ */
+
+static double reference(
+    int inner_reps,
+    int length)
+{
+    double t0 = omp_get_wtime();
+    for (int j = 0; j < inner_reps; j++)
+        delay(length);
+    return omp_get_wtime() - t0;
+}
+
+static double test_parallel(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    double t0 = omp_get_wtime();
+    for (int j = 0; j < inner_reps; j++) {
+        #pragma omp parallel num_threads(num_threads)
+        delay(length);
+    }
+    return omp_get_wtime() - t0;
+}
+
+static double test_barrier(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(num_threads)
+    for (int j = 0; j < inner_reps; j++) {
+        delay(length);
+        #pragma omp barrier
+    }
+    return omp_get_wtime() - t0;
+}
+
+static double test_for_static(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(num_threads)
+    for (int j = 0; j < inner_reps; j++) {
+        #pragma omp for schedule(static)
+        for (int i = 0; i < num_threads; i++)
+            delay(length);
+    }
+    return omp_get_wtime() - t0;
+}
+
+static double test_for_dynamic(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(num_threads)
+    for (int j = 0; j < inner_reps; j++) {
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < num_threads; i++)
+            delay(length);
+    }
+    return omp_get_wtime() - t0;
+}
+
+static double test_for_guided(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(num_threads)
+    for (int j = 0; j < inner_reps; j++) {
+        #pragma omp for schedule(guided)
+        for (int i = 0; i < num_threads; i++)
+            delay(length);
+    }
+    return omp_get_wtime() - t0;
+}
+
+static double test_reduction(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    int a = 0;
+    double t0 = omp_get_wtime();
+    for (int j = 0; j < inner_reps; j++) {
+        #pragma omp parallel num_threads(num_threads) reduction(+:a)
+        {
+            delay(length);
+            a += 1;
+        }
+    }
+    double t = omp_get_wtime() - t0;
+    if (a != inner_reps * num_threads)
+        fprintf(stderr, "ompbench: reduction gave %d, expected %d\n",
+                a, inner_reps * num_threads);
+    return t;
+}
+
+static double test_err_add(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    int err = 0;
+    double t0 = omp_get_wtime();
+    for (int j = 0; j < inner_reps; j++) {
+        #pragma omp parallel num_threads(num_threads) reduction(err_add:err)
+        {
+            delay(length);
+            err = err ? err : (j & 1);
+        }
+    }
+    return omp_get_wtime() - t0;
+}
+
+static double test_atomic(
+    int num_threads,
+    int inner_reps,
+    int length)
+{
+    int a = 0;
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(num_threads)
+    for (int j = 0; j < inner_reps / num_threads; j++) {
+        delay(length);
+        #pragma omp atomic
+        a += 1;
+    }
+    double t = omp_get_wtime() - t0;
+    if (a != (inner_reps / num_threads) * num_threads)
+        fprintf(stderr, "ompbench: atomic gave %d, expected %d\n",
+                a, (inner_reps / num_threads) * num_threads);
+    return t;
+}
+
+/**
+ * `ompbench()` measures the overhead of OpenMP constructs for a
+ * given number of threads.
+ */
+int ompbench(
+    int num_threads,
+    int inner_reps,
+    int outer_reps,
+    struct ompbench_result * result)
+{
+    if (num_threads <= 0 || inner_reps <= 0 || outer_reps <= 0)
+        return EINVAL;
+
+    /* Calibrate the delay loop to take about 0.1 microseconds. */
+    int length = delay_length(1e-7);
+
+    /* Warm up the thread pool before measuring. */
+    test_parallel(num_threads, inner_reps, length);
+
+    struct ompbench_result sum = {0};
+    int atomic_reps = inner_reps / num_threads > 0
+        ? inner_reps / num_threads : 1;
+    for (int k = 0; k < outer_reps; k++) {
+        double ref = reference(inner_reps, length);
+        sum.parallel += test_parallel(num_threads, inner_reps, length) - ref;
+        sum.barrier += test_barrier(num_threads, inner_reps, length) - ref;
+        sum.for_static += test_for_static(num_threads, inner_reps, length) - ref;
+        sum.for_dynamic += test_for_dynamic(num_threads, inner_reps, length) - ref;
+        sum.for_guided += test_for_guided(num_threads, inner_reps, length) - ref;
+        sum.reduction += test_reduction(num_threads, inner_reps, length) - ref;
+        sum.err_add += test_err_add(num_threads, inner_reps, length) - ref;
+        double atomic_ref = reference(atomic_reps, length);
+        sum.atomic += (test_atomic(
+            num_threads, atomic_reps * num_threads, length) - atomic_ref)
+            * inner_reps / atomic_reps;
+    }
+
+    double scale = 1.0 / ((double) inner_reps * outer_reps);
+    result->num_threads = num_threads;
+    result->parallel = sum.parallel * scale;
+    result->barrier = sum.barrier * scale;
+    result->for_static = sum.for_static * scale;
+    result->for_dynamic = sum.for_dynamic * scale;
+    result->for_guided = sum.for_guided * scale;
+    result->reduction = sum.reduction * scale;
+    result->err_add = sum.err_add * scale;
+    result->atomic = sum.atomic * scale;
+    return 0;
+}
+
+/**
+ * `ompbench_thread_counts()` returns the thread counts for which the
+ * OpenMP overhead is measured.
+ */
+int ompbench_thread_counts(
+    int max_counts,
+    int * thread_counts)
+{
+    int max_threads = omp_get_max_threads();
+    int num_counts = 0;
+    for (int n = 1; n < max_threads && num_counts < max_counts; n *= 2)
+        thread_counts[num_counts++] = n;
+    if (num_counts < max_counts)
+        thread_counts[num_counts++] = max_threads;
+    return num_counts;
+}
+
+#else
+
+/**
+ * `ompbench()` measures the overhead of OpenMP constructs for a
+ * given number of threads.
+ */
+int ompbench(
+    int num_threads,
+    int inner_reps,
+    int outer_reps,
+    struct ompbench_result * result)
+{
+    return ENOTSUP;
+}
+
+/**
+ * `ompbench_thread_counts()` returns the thread counts for which the
+ * OpenMP overhead is measured.
+ */
+int ompbench_thread_counts(
+    int max_counts,
+    int * thread_counts)
+{
+    if (max_counts <= 0)
+        return 0;
+    thread_counts[0] = 1;
+    return 1;
+}
+
+#endif
+
+/**
+ * `ompbench_print()` prints the overhead of OpenMP constructs in
+ * microseconds.
+ */
+void ompbench_print(
+    const struct ompbench_result * result,
+    FILE * f)
+{
+    fprintf(f, "omp-overhead: %d threads parallel: %.3f us barrier: %.3f us "
+            "for-static: %.3f us for-dynamic: %.3f us for-guided: %.3f us "
+            "reduction: %.3f us err_add: %.3f us atomic: %.3f us\n",
+            result->num_threads,
+            result->parallel * 1e6, result->barrier * 1e6,
+            result->for_static * 1e6, result->for_dynamic * 1e6,
+            result->for_guided * 1e6, result->reduction * 1e6,
+            result->err_add * 1e6, result->atomic * 1e6);
+}
@@ -0,0 +1,87 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Microbenchmarks for the overhead of OpenMP synchronisation and
+ * scheduling constructs, following the methodology of the EPCC
+ * OpenMP microbenchmarks.
+ */
+
+#ifndef OMPBENCH_H
+#define OMPBENCH_H
+
+#include <stdio.h>
+
+/**
+ * `ompbench_result` contains the overhead, in seconds, of executing
+ * a single instance of each OpenMP construct with a given number of
+ * threads.
+ */
+struct ompbench_result
+{
+    int num_threads;
+    double parallel;
+    double barrier;
+    double for_static;
+    double for_dynamic;
+    double for_guided;
+    double reduction;
+    double err_add;
+    double atomic;
+};
+
+/**
+ * `ompbench()` measures the overhead of OpenMP constructs for a
+ * given number of threads.
+ *
+ * Each construct is executed `inner_reps` times around a short delay
+ * loop, and the time taken is compared to that of executing the delay
+ * loop alone. The difference, divided by `inner_reps`, is the
+ * overhead of the construct. This is repeated `outer_reps` times, and
+ * the mean overhead is reported.
+ *
+ * If the program is compiled without OpenMP support, `ompbench()`
+ * returns `ENOTSUP`.
+ */
+int ompbench(
+    int num_threads,
+    int inner_reps,
+    int outer_reps,
+    struct ompbench_result * result);
+
+/**
+ * `ompbench_thread_counts()` returns the thread counts for which the
+ * OpenMP overhead is measured, which are the powers of two up to, and
+ * including, the maximum number of threads.
+ *
+ * At most `max_counts` thread counts are stored in `thread_counts`,
+ * and the number of thread counts is returned.
+ */
+int ompbench_thread_counts(
+    int max_counts,
+    int * thread_counts);
+
+/**
+ * `ompbench_print()` prints the overhead of OpenMP constructs in
+ * microseconds.
+ */
+void ompbench_print(
+    const struct ompbench_result * result,
+    FILE * f);
+
+#endif
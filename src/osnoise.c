@@ -0,0 +1,231 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Fixed-work-quantum probes of operating system noise.
+ */
+
+#define _GNU_SOURCE
+
+#include "osnoise.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `work()` performs a fixed amount of work that the compiler cannot
+ * optimise away.
+ */
+static void work(
+    int64_t iterations)
+{
+    volatile double a = 0.0;
+    for (int64_t i = 0; i < iterations; i++)
+        a += i;
+}
+
+/**
+ * `time_work()` is the time taken to perform a given amount of work.
+ */
+static double time_work(
+    int64_t iterations)
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    work(iterations);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return timespec_duration(t0, t1);
+}
+
+/**
+ * `osnoise_thread` is the state of a thread that probes a CPU.
+ */
+struct osnoise_thread
+{
+    int num_samples;
+    double quantum;
+    struct osnoise_cpu * result;
+    int err;
+};
+
+/**
+ * `osnoise_thread_main()` binds the calling thread to its CPU and
+ * performs fixed quanta of work.
+ */
+static void * osnoise_thread_main(
+    void * arg)
+{
+    struct osnoise_thread * thread = arg;
+    struct osnoise_cpu * result = thread->result;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(result->cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set)) {
+        thread->err = errno;
+        return NULL;
+    }
+
+    /*
+     * Calibrate the quantum, using the fastest of several attempts so
+     * that the calibration itself is not skewed by noise.
+     */
+    int64_t iterations = 16;
+    while (iterations < (INT64_C(1) << 40)) {
+        double t = time_work(iterations);
+        for (int i = 0; i < 4; i++) {
+            double u = time_work(iterations);
+            if (t > u)
+                t = u;
+        }
+        if (t >= thread->quantum)
+            break;
+        iterations *= 2;
+    }
+
+    double * samples = malloc(thread->num_samples * sizeof(double));
+    if (!samples) {
+        thread->err = errno;
+        return NULL;
+    }
+    for (int i = 0; i < thread->num_samples; i++)
+        samples[i] = time_work(iterations);
+
+    double min = INFINITY, max = 0.0, sum = 0.0;
+    for (int i = 0; i < thread->num_samples; i++) {
+        sum += samples[i];
+        if (min > samples[i])
+            min = samples[i];
+        if (max < samples[i])
+            max = samples[i];
+    }
+    double mean = sum / thread->num_samples;
+    double sum_squares = 0.0;
+    for (int i = 0; i < thread->num_samples; i++)
+        sum_squares += (samples[i] - mean) * (samples[i] - mean);
+    free(samples);
+
+    result->num_samples = thread->num_samples;
+    result->quantum = min;
+    result->mean = mean;
+    result->max = max;
+    result->stddev = thread->num_samples > 1
+        ? sqrt(sum_squares / (thread->num_samples - 1)) : 0.0;
+    result->score = min > 0 ? (mean - min) / min : 0.0;
+    return NULL;
+}
+
+/**
+ * `osnoise_probe()` measures operating system noise on a CPU.
+ */
+int osnoise_probe(
+    int cpu,
+    int num_samples,
+    double quantum,
+    struct osnoise_cpu * result)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE || num_samples <= 0)
+        return EINVAL;
+    result->cpu = cpu;
+    struct osnoise_thread thread = {num_samples, quantum, result, 0};
+    pthread_t id;
+    int err = pthread_create(&id, NULL, osnoise_thread_main, &thread);
+    if (err)
+        return err;
+    pthread_join(id, NULL);
+    return thread.err;
+}
+
+/**
+ * `osnoise_recommend()` orders CPUs from the quietest to the noisiest
+ * and stores up to `max_cpus` of them in `cpus`.
+ */
+int osnoise_recommend(
+    int num_probes,
+    const struct osnoise_cpu * probes,
+    int max_cpus,
+    int * cpus)
+{
+    int num_cpus = 0;
+    for (int i = 0; i < num_probes && num_cpus < max_cpus; i++) {
+        /* Select the quietest CPU that has not yet been selected. */
+        int best = -1;
+        for (int j = 0; j < num_probes; j++) {
+            bool selected = false;
+            for (int k = 0; k < num_cpus; k++) {
+                if (cpus[k] == probes[j].cpu)
+                    selected = true;
+            }
+            if (!selected && (best < 0 || probes[j].score < probes[best].score))
+                best = j;
+        }
+        if (best < 0)
+            break;
+        cpus[num_cpus++] = probes[best].cpu;
+    }
+    return num_cpus;
+}
+
+/**
+ * `osnoise_predicted_cv()` predicts the coefficient of variation of
+ * the duration of a run of the given length on a probed CPU.
+ */
+double osnoise_predicted_cv(
+    const struct osnoise_cpu * probe,
+    double duration)
+{
+    if (!(probe->mean > 0) || !(duration > 0))
+        return 0.0;
+    double cv = probe->stddev / probe->mean;
+    double num_quanta = duration / probe->mean;
+    return num_quanta > 1 ? cv / sqrt(num_quanta) : cv;
+}
+
+/**
+ * `osnoise_print()` prints the noise measured on a CPU.
+ */
+void osnoise_print(
+    const struct osnoise_cpu * probe,
+    FILE * f)
+{
+    fprintf(f, "cpu%d: %d quanta of %.3f us mean: +%.2f%% max: +%.1f%% "
+            "cv: %.2f%% score: %.5f",
+            probe->cpu, probe->num_samples, probe->quantum * 1e6,
+            100.0 * (probe->mean - probe->quantum) / probe->quantum,
+            100.0 * (probe->max - probe->quantum) / probe->quantum,
+            100.0 * probe->stddev / probe->mean, probe->score);
+}
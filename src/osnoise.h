@@ -0,0 +1,89 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Fixed-work-quantum probes of operating system noise.
+ */
+
+#ifndef OSNOISE_H
+#define OSNOISE_H
+
+#include <stdio.h>
+
+/**
+ * `osnoise_cpu` summarises the interruptions observed on a CPU while
+ * it repeatedly performs a fixed quantum of work.
+ */
+struct osnoise_cpu
+{
+    int cpu;
+    int num_samples;
+    double quantum; /* fastest time to perform one quantum, in seconds */
+    double mean;    /* mean time per quantum, in seconds */
+    double max;     /* slowest time per quantum, in seconds */
+    double stddev;  /* standard deviation of the time per quantum */
+    double score;   /* fraction of time lost to noise, (mean-quantum)/quantum */
+};
+
+/**
+ * `osnoise_probe()` measures operating system noise on a CPU.
+ *
+ * A thread bound to the CPU performs `num_samples` quanta of work,
+ * each calibrated to take roughly `quantum` seconds without
+ * interruption, and times each quantum separately (FWQ). Timer ticks,
+ * interrupts and other processes that run on the CPU show up as
+ * quanta that take longer than the fastest one.
+ */
+int osnoise_probe(
+    int cpu,
+    int num_samples,
+    double quantum,
+    struct osnoise_cpu * result);
+
+/**
+ * `osnoise_recommend()` orders CPUs from the quietest to the noisiest
+ * and stores up to `max_cpus` of them in `cpus`.
+ *
+ * The number of CPUs stored is returned.
+ */
+int osnoise_recommend(
+    int num_probes,
+    const struct osnoise_cpu * probes,
+    int max_cpus,
+    int * cpus);
+
+/**
+ * `osnoise_predicted_cv()` predicts the coefficient of variation of
+ * the duration of a run of the given length on a probed CPU.
+ *
+ * The variation of the noise is assumed to be independent from one
+ * quantum to the next, so that it averages out over the
+ * `duration / quantum` quanta that make up a run.
+ */
+double osnoise_predicted_cv(
+    const struct osnoise_cpu * probe,
+    double duration);
+
+/**
+ * `osnoise_print()` prints the noise measured on a CPU.
+ */
+void osnoise_print(
+    const struct osnoise_cpu * probe,
+    FILE * f);
+
+#endif
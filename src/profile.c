@@ -0,0 +1,916 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Sampling profiler that attributes time to functions.
+ */
+
+#define _GNU_SOURCE
+
+#include "profile.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <link.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The number of data pages in the ring buffer of each thread. */
+#define PROFILE_RING_PAGES 256
+
+/* The maximum number of samples that are kept. */
+#define PROFILE_MAX_SAMPLES (1 << 20)
+
+/**
+ * `profile_method_str()` is a string representing a given way of
+ * sampling the instruction pointer.
+ */
+const char * profile_method_str(
+    enum profile_method profile_method)
+{
+    switch (profile_method) {
+    case profile_perf_cycles: return "perf cycles";
+    case profile_perf_clock: return "perf cpu-clock";
+    case profile_itimer: return "itimer";
+    default: return "unknown";
+    }
+}
+
+/**
+ * `thread_num()` is the OpenMP thread number of the calling thread.
+ */
+static int thread_num(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * `perf_open()` opens a sampling event for the calling thread and
+ * maps its ring buffer.
+ */
+static int perf_open(
+    enum profile_method method,
+    int frequency,
+    size_t ring_size,
+    int * fd,
+    void ** ring)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    if (method == profile_perf_cycles) {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    } else {
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_CPU_CLOCK;
+    }
+    attr.freq = 1;
+    attr.sample_freq = frequency;
+    attr.sample_type = PERF_SAMPLE_IP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    *fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (*fd < 0)
+        return errno;
+    *ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (*ring == MAP_FAILED) {
+        int err = errno;
+        close(*fd);
+        *fd = -1;
+        *ring = NULL;
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `perf_close()` closes the sampling events of all threads.
+ */
+static void perf_close(
+    struct profile * profile)
+{
+    for (int i = 0; i < profile->num_threads; i++) {
+        if (profile->rings[i])
+            munmap(profile->rings[i], profile->ring_size);
+        if (profile->fds[i] >= 0)
+            close(profile->fds[i]);
+        profile->rings[i] = NULL;
+        profile->fds[i] = -1;
+    }
+}
+
+/**
+ * `perf_start()` opens a sampling event for each thread of a parallel
+ * region.
+ */
+static int perf_start(
+    struct profile * profile)
+{
+    int err = 0;
+    for (int i = 0; i < profile->num_threads; i++) {
+        profile->fds[i] = -1;
+        profile->rings[i] = NULL;
+    }
+    #pragma omp parallel num_threads(profile->num_threads)
+    {
+        int i = thread_num();
+        int thread_err = perf_open(
+            profile->method, profile->frequency, profile->ring_size,
+            &profile->fds[i], &profile->rings[i]);
+        if (thread_err) {
+            #pragma omp critical
+            err = thread_err;
+        }
+    }
+    if (err)
+        perf_close(profile);
+    return err;
+}
+
+/**
+ * `perf_read()` copies bytes from a ring buffer, which may wrap
+ * around.
+ */
+static void perf_read(
+    const char * data,
+    size_t data_size,
+    uint64_t offset,
+    void * dst,
+    size_t size)
+{
+    char * p = dst;
+    for (size_t i = 0; i < size; i++)
+        p[i] = data[(offset + i) % data_size];
+}
+
+/**
+ * `perf_drain()` collects the samples from the ring buffer of a
+ * thread.
+ */
+static void perf_drain(
+    struct profile * profile,
+    void * ring)
+{
+    struct perf_event_mmap_page * page = ring;
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    const char * data = (const char *) ring + page_size;
+    size_t data_size = profile->ring_size - page_size;
+    uint64_t head = atomic_load_explicit(
+        (_Atomic uint64_t *) &page->data_head, memory_order_acquire);
+    uint64_t tail = page->data_tail;
+    while (tail < head) {
+        struct perf_event_header header;
+        perf_read(data, data_size, tail, &header, sizeof(header));
+        if (header.size < sizeof(header))
+            break;
+        if (header.type == PERF_RECORD_SAMPLE) {
+            uint64_t ip;
+            perf_read(data, data_size, tail + sizeof(header), &ip, sizeof(ip));
+            size_t i = atomic_load(&profile->num_ips);
+            if (i < profile->max_ips) {
+                profile->ips[i] = ip;
+                atomic_store(&profile->num_ips, i+1);
+            } else {
+                profile->num_lost++;
+            }
+        } else if (header.type == PERF_RECORD_LOST) {
+            uint64_t lost[2];
+            perf_read(data, data_size, tail + sizeof(header), lost, sizeof(lost));
+            profile->num_lost += lost[1];
+        }
+        tail += header.size;
+    }
+    atomic_store_explicit(
+        (_Atomic uint64_t *) &page->data_tail, tail, memory_order_release);
+}
+
+/**
+ * `perf_drainer_main()` drains the ring buffers every
+ * `PROFILE_DRAIN_INTERVAL` nanoseconds until it is told to stop.
+ */
+static void * perf_drainer_main(
+    void * arg)
+{
+    struct profile * profile = arg;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    pthread_mutex_lock(&profile->mutex);
+    while (!profile->stop) {
+        deadline.tv_nsec += PROFILE_DRAIN_INTERVAL;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        while (!profile->stop &&
+               pthread_cond_timedwait(&profile->cond, &profile->mutex, &deadline) != ETIMEDOUT)
+            ;
+        if (profile->stop)
+            break;
+        for (int i = 0; i < profile->num_threads; i++)
+            perf_drain(profile, profile->rings[i]);
+    }
+    pthread_mutex_unlock(&profile->mutex);
+    return NULL;
+}
+
+/**
+ * `perf_drainer_start()` starts a thread that drains the ring
+ * buffers while sampling.
+ */
+static int perf_drainer_start(
+    struct profile * profile)
+{
+    profile->stop = false;
+
+    /* The condition variable waits on the monotonic clock. */
+    pthread_condattr_t attr;
+    int err = pthread_condattr_init(&attr);
+    if (err)
+        return err;
+    err = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (!err)
+        err = pthread_cond_init(&profile->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (err)
+        return err;
+    err = pthread_mutex_init(&profile->mutex, NULL);
+    if (err) {
+        pthread_cond_destroy(&profile->cond);
+        return err;
+    }
+    err = pthread_create(&profile->drainer, NULL, perf_drainer_main, profile);
+    if (err) {
+        pthread_mutex_destroy(&profile->mutex);
+        pthread_cond_destroy(&profile->cond);
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `perf_drainer_stop()` stops the thread that drains the ring
+ * buffers.
+ */
+static void perf_drainer_stop(
+    struct profile * profile)
+{
+    pthread_mutex_lock(&profile->mutex);
+    profile->stop = true;
+    pthread_cond_signal(&profile->cond);
+    pthread_mutex_unlock(&profile->mutex);
+    pthread_join(profile->drainer, NULL);
+    pthread_mutex_destroy(&profile->mutex);
+    pthread_cond_destroy(&profile->cond);
+}
+
+/* The profile that receives samples from the `SIGPROF' handler. */
+static struct profile * itimer_profile;
+static struct sigaction itimer_oldaction;
+
+/**
+ * `context_ip()` is the instruction pointer of a thread that was
+ * interrupted by a signal.
+ */
+static uintptr_t context_ip(
+    void * context)
+{
+    ucontext_t * uc = context;
+#if defined(__x86_64__)
+    return uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+    return uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+    return uc->uc_mcontext.pc;
+#else
+    (void) uc;
+    return 0;
+#endif
+}
+
+/**
+ * `itimer_handler()` records the instruction pointer of the thread
+ * that received `SIGPROF'.
+ */
+static void itimer_handler(
+    int signum,
+    siginfo_t * info,
+    void * context)
+{
+    struct profile * profile = itimer_profile;
+    if (!profile)
+        return;
+    size_t i = atomic_fetch_add(&profile->num_ips, 1);
+    if (i < profile->max_ips)
+        profile->ips[i] = context_ip(context);
+}
+
+/**
+ * `itimer_start()` starts sampling the process with `SIGPROF'.
+ */
+static int itimer_start(
+    struct profile * profile)
+{
+#if !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__)
+    return ENOTSUP;
+#endif
+    if (itimer_profile)
+        return EBUSY;
+    itimer_profile = profile;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = itimer_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &itimer_oldaction)) {
+        itimer_profile = NULL;
+        return errno;
+    }
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = profile->frequency < 1000000
+        ? 1000000 / profile->frequency : 1;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL)) {
+        int err = errno;
+        sigaction(SIGPROF, &itimer_oldaction, NULL);
+        itimer_profile = NULL;
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `itimer_stop()` stops sampling the process with `SIGPROF'.
+ */
+static void itimer_stop(
+    struct profile * profile)
+{
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &itimer_oldaction, NULL);
+    itimer_profile = NULL;
+    size_t num_ips = atomic_load(&profile->num_ips);
+    if (num_ips > profile->max_ips) {
+        profile->num_lost = num_ips - profile->max_ips;
+        atomic_store(&profile->num_ips, profile->max_ips);
+    }
+}
+
+/**
+ * `profile_start()` starts sampling the instruction pointer of each
+ * thread of a parallel region.
+ */
+int profile_start(
+    struct profile * profile,
+    int num_threads,
+    int frequency)
+{
+    if (num_threads <= 0 || frequency <= 0)
+        return EINVAL;
+    profile->frequency = frequency;
+    profile->num_threads = num_threads;
+    profile->ring_size = (1 + PROFILE_RING_PAGES) * sysconf(_SC_PAGESIZE);
+    profile->max_ips = PROFILE_MAX_SAMPLES;
+    atomic_init(&profile->num_ips, 0);
+    profile->num_lost = 0;
+    profile->fds = malloc(num_threads * sizeof(int));
+    profile->rings = malloc(num_threads * sizeof(void *));
+    profile->ips = malloc(profile->max_ips * sizeof(uintptr_t));
+    if (!profile->fds || !profile->rings || !profile->ips) {
+        int err = errno;
+        free(profile->ips);
+        free(profile->rings);
+        free(profile->fds);
+        return err;
+    }
+
+    /* Prefer cycles, then CPU time, and finally the interval timer. */
+    int err = 0;
+    for (int method = 0; method < num_profile_methods; method++) {
+        profile->method = method;
+        if (method == profile_itimer) {
+            err = itimer_start(profile);
+        } else {
+            err = perf_start(profile);
+            if (!err) {
+                err = perf_drainer_start(profile);
+                if (err)
+                    perf_close(profile);
+            }
+        }
+        if (!err)
+            break;
+    }
+    if (err) {
+        free(profile->ips);
+        free(profile->rings);
+        free(profile->fds);
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `profile_stop()` stops sampling and collects the samples.
+ */
+int profile_stop(
+    struct profile * profile)
+{
+    if (profile->method == profile_itimer) {
+        itimer_stop(profile);
+        return 0;
+    }
+    for (int i = 0; i < profile->num_threads; i++) {
+        if (profile->fds[i] >= 0)
+            ioctl(profile->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    perf_drainer_stop(profile);
+    for (int i = 0; i < profile->num_threads; i++) {
+        if (profile->rings[i])
+            perf_drain(profile, profile->rings[i]);
+    }
+    perf_close(profile);
+    return 0;
+}
+
+/**
+ * `profile_free()` frees resources associated with a profile.
+ */
+void profile_free(
+    struct profile * profile)
+{
+    free(profile->ips);
+    free(profile->rings);
+    free(profile->fds);
+    profile->ips = NULL;
+    profile->rings = NULL;
+    profile->fds = NULL;
+}
+
+/**
+ * `elf_symbol` is a function in the symbol table of an ELF file.
+ */
+struct elf_symbol
+{
+    uintptr_t value;
+    size_t size;
+    const char * name;
+};
+
+/**
+ * `elf_section` is a section of an ELF file that contains code, such
+ * as `.text' or `.plt'.
+ */
+struct elf_section
+{
+    uintptr_t start;
+    uintptr_t end;
+    const char * name;
+};
+
+/**
+ * `elf_object` is the symbol table of a loaded shared object or
+ * executable.
+ */
+struct elf_object
+{
+    uintptr_t base;
+    uintptr_t vaddr;
+    void * maps[2];
+    size_t map_sizes[2];
+    int num_symbols;
+    struct elf_symbol * symbols;
+    int num_sections;
+    struct elf_section * sections;
+};
+
+/**
+ * `compare_elf_symbols()` orders functions by address.
+ */
+static int compare_elf_symbols(
+    const void * a,
+    const void * b)
+{
+    const struct elf_symbol * x = a;
+    const struct elf_symbol * y = b;
+    return x->value < y->value ? -1 : (x->value > y->value);
+}
+
+/**
+ * `elf_map()` maps an ELF file into memory and checks its headers.
+ */
+static int elf_map(
+    const char * path,
+    void ** map,
+    size_t * size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+    struct stat st;
+    if (fstat(fd, &st)) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+    if (st.st_size < (off_t) sizeof(ElfW(Ehdr))) {
+        close(fd);
+        return ENOEXEC;
+    }
+    *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = *map == MAP_FAILED ? errno : 0;
+    close(fd);
+    if (err)
+        return err;
+    *size = st.st_size;
+
+    const ElfW(Ehdr) * ehdr = *map;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr->e_ident[EI_CLASS] != (sizeof(void *) == 8 ? ELFCLASS64 : ELFCLASS32) ||
+        ehdr->e_shentsize != sizeof(ElfW(Shdr)) ||
+        ehdr->e_shstrndx >= ehdr->e_shnum ||
+        ehdr->e_shoff + (size_t) ehdr->e_shnum * sizeof(ElfW(Shdr)) > *size ||
+        ehdr->e_phoff + (size_t) ehdr->e_phnum * sizeof(ElfW(Phdr)) > *size) {
+        munmap(*map, *size);
+        return ENOEXEC;
+    }
+    return 0;
+}
+
+/**
+ * `elf_symbols()` reads the functions in the symbol table of a mapped
+ * ELF file, or in its dynamic symbol table if `dynsym` is true.
+ */
+static int elf_symbols(
+    struct elf_object * object,
+    const char * file,
+    size_t size,
+    bool dynsym)
+{
+    const ElfW(Ehdr) * ehdr = (const ElfW(Ehdr) *) file;
+    const ElfW(Shdr) * shdrs = (const ElfW(Shdr) *) (file + ehdr->e_shoff);
+    const ElfW(Shdr) * symtab = NULL;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (shdrs[i].sh_type == (dynsym ? SHT_DYNSYM : SHT_SYMTAB))
+            symtab = &shdrs[i];
+    }
+    if (!symtab || symtab->sh_link >= ehdr->e_shnum ||
+        symtab->sh_offset + symtab->sh_size > size)
+        return ENOENT;
+    const ElfW(Shdr) * strtab = &shdrs[symtab->sh_link];
+    if (strtab->sh_offset + strtab->sh_size > size)
+        return ENOEXEC;
+
+    const ElfW(Sym) * syms = (const ElfW(Sym) *) (file + symtab->sh_offset);
+    size_t num_syms = symtab->sh_size / sizeof(ElfW(Sym));
+    struct elf_symbol * symbols = malloc(num_syms * sizeof(struct elf_symbol));
+    if (!symbols)
+        return errno;
+    int num_symbols = 0;
+    for (size_t i = 0; i < num_syms; i++) {
+        int type = ELF64_ST_TYPE(syms[i].st_info);
+        if ((type != STT_FUNC && type != STT_GNU_IFUNC) ||
+            syms[i].st_shndx == SHN_UNDEF || syms[i].st_value == 0 ||
+            syms[i].st_name >= strtab->sh_size)
+            continue;
+        symbols[num_symbols].value = syms[i].st_value;
+        symbols[num_symbols].size = syms[i].st_size;
+        symbols[num_symbols].name = file + strtab->sh_offset + syms[i].st_name;
+        num_symbols++;
+    }
+    if (num_symbols == 0) {
+        free(symbols);
+        return ENOENT;
+    }
+    qsort(symbols, num_symbols, sizeof(struct elf_symbol), compare_elf_symbols);
+    object->num_symbols = num_symbols;
+    object->symbols = symbols;
+    return 0;
+}
+
+/**
+ * `elf_debug_path()` is the path to the separate debug information of
+ * a stripped ELF file, which is found from its build ID.
+ */
+static int elf_debug_path(
+    const char * file,
+    size_t size,
+    char * path,
+    size_t path_size)
+{
+    const ElfW(Ehdr) * ehdr = (const ElfW(Ehdr) *) file;
+    const ElfW(Shdr) * shdrs = (const ElfW(Shdr) *) (file + ehdr->e_shoff);
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (shdrs[i].sh_type != SHT_NOTE ||
+            shdrs[i].sh_offset + shdrs[i].sh_size > size)
+            continue;
+        const char * note = file + shdrs[i].sh_offset;
+        const char * end = note + shdrs[i].sh_size;
+        while (note + sizeof(ElfW(Nhdr)) <= end) {
+            const ElfW(Nhdr) * nhdr = (const ElfW(Nhdr) *) note;
+            const char * name = note + sizeof(ElfW(Nhdr));
+            const unsigned char * desc = (const unsigned char *)
+                name + ((nhdr->n_namesz + 3) & ~3u);
+            if ((const char *) desc + nhdr->n_descsz > end)
+                break;
+            if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 &&
+                memcmp(name, "GNU", 4) == 0 && nhdr->n_descsz > 1) {
+                size_t len = snprintf(path, path_size,
+                                      "/usr/lib/debug/.build-id/%02x/", desc[0]);
+                for (unsigned int j = 1; j < nhdr->n_descsz && len < path_size; j++)
+                    len += snprintf(path + len, path_size - len, "%02x", desc[j]);
+                if (len < path_size)
+                    len += snprintf(path + len, path_size - len, ".debug");
+                return len < path_size ? 0 : ENAMETOOLONG;
+            }
+            note = (const char *) desc + ((nhdr->n_descsz + 3) & ~3u);
+        }
+    }
+    return ENOENT;
+}
+
+/**
+ * `elf_object_load()` reads the functions and code sections of a
+ * loaded ELF file.
+ *
+ * The symbol table of the file is used if present. Otherwise, the
+ * symbol table of its separate debug information is used, if it is
+ * installed, and, finally, the dynamic symbol table.
+ */
+static int elf_object_load(
+    struct elf_object * object,
+    const char * path,
+    uintptr_t base)
+{
+    memset(object, 0, sizeof(*object));
+    object->base = base;
+    int err = elf_map(path, &object->maps[0], &object->map_sizes[0]);
+    if (err) {
+        object->maps[0] = NULL;
+        return err;
+    }
+    const char * file = object->maps[0];
+    size_t size = object->map_sizes[0];
+    const ElfW(Ehdr) * ehdr = (const ElfW(Ehdr) *) file;
+
+    /* Symbol values are relative to the lowest loaded address. */
+    const ElfW(Phdr) * phdrs = (const ElfW(Phdr) *) (file + ehdr->e_phoff);
+    bool have_vaddr = false;
+    for (int i = 0; i < ehdr->e_phnum; i++) {
+        if (phdrs[i].p_type != PT_LOAD)
+            continue;
+        uintptr_t vaddr = phdrs[i].p_vaddr & ~(uintptr_t) (sysconf(_SC_PAGESIZE)-1);
+        if (!have_vaddr || object->vaddr > vaddr)
+            object->vaddr = vaddr;
+        have_vaddr = true;
+    }
+
+    /* Find the sections that contain code. */
+    const ElfW(Shdr) * shdrs = (const ElfW(Shdr) *) (file + ehdr->e_shoff);
+    const ElfW(Shdr) * shstrtab = &shdrs[ehdr->e_shstrndx];
+    if (shstrtab->sh_offset + shstrtab->sh_size <= size) {
+        object->sections = malloc(ehdr->e_shnum * sizeof(struct elf_section));
+        if (!object->sections)
+            return errno;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            if (!(shdrs[i].sh_flags & SHF_EXECINSTR) ||
+                shdrs[i].sh_name >= shstrtab->sh_size)
+                continue;
+            struct elf_section * section = &object->sections[object->num_sections++];
+            section->start = shdrs[i].sh_addr;
+            section->end = shdrs[i].sh_addr + shdrs[i].sh_size;
+            section->name = file + shstrtab->sh_offset + shdrs[i].sh_name;
+        }
+    }
+
+    err = elf_symbols(object, file, size, false);
+    if (err) {
+        char debug_path[512];
+        if (!elf_debug_path(file, size, debug_path, sizeof(debug_path)) &&
+            !elf_map(debug_path, &object->maps[1], &object->map_sizes[1])) {
+            err = elf_symbols(object, object->maps[1], object->map_sizes[1], false);
+        } else {
+            object->maps[1] = NULL;
+        }
+    }
+    if (err)
+        err = elf_symbols(object, file, size, true);
+    return err;
+}
+
+/**
+ * `elf_object_free()` frees the symbol table of an ELF file.
+ */
+static void elf_object_free(
+    struct elf_object * object)
+{
+    free(object->sections);
+    free(object->symbols);
+    for (int i = 0; i < 2; i++) {
+        if (object->maps[i])
+            munmap(object->maps[i], object->map_sizes[i]);
+    }
+}
+
+/**
+ * `elf_object_find()` finds the function that contains a given
+ * address, or, failing that, the section that contains it. If there
+ * is neither, then `NULL` is returned.
+ */
+static const char * elf_object_find(
+    const struct elf_object * object,
+    uintptr_t ip,
+    bool * section)
+{
+    *section = false;
+    uintptr_t address = ip - object->base + object->vaddr;
+    int lo = 0, hi = object->num_symbols;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (object->symbols[mid].value <= address)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+
+    /* Several symbols, such as aliases, may start at the same address. */
+    for (int i = lo-1; i >= 0 && i >= lo-8; i--) {
+        const struct elf_symbol * symbol = &object->symbols[i];
+        if (address < symbol->value + (symbol->size ? symbol->size : 1))
+            return symbol->name;
+    }
+    for (int i = 0; i < object->num_sections; i++) {
+        const struct elf_section * s = &object->sections[i];
+        if (address >= s->start && address < s->end) {
+            *section = true;
+            return s->name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * `profile_entry` is the number of samples attributed to a function.
+ */
+struct profile_entry
+{
+    const char * function;
+    const char * object;
+    bool section;
+    int64_t count;
+};
+
+/**
+ * `compare_profile_entries()` orders functions by decreasing number
+ * of samples.
+ */
+static int compare_profile_entries(
+    const void * a,
+    const void * b)
+{
+    const struct profile_entry * x = a;
+    const struct profile_entry * y = b;
+    return x->count > y->count ? -1 : (x->count < y->count);
+}
+
+/**
+ * `profile_print()` prints a flat profile with the `max_functions`
+ * functions that received the most samples.
+ */
+void profile_print(
+    const struct profile * profile,
+    int max_functions,
+    FILE * f)
+{
+    size_t num_ips = atomic_load(&profile->num_ips);
+    fprintf(f, "profile: %s %d Hz: %zu samples %"PRId64" lost\n",
+            profile_method_str(profile->method), profile->frequency,
+            num_ips, profile->num_lost);
+    if (num_ips == 0)
+        return;
+
+    int num_objects = 0, max_objects = 0;
+    struct elf_object * objects = NULL;
+    int num_entries = 0, max_entries = 0;
+    struct profile_entry * entries = NULL;
+    for (size_t i = 0; i < num_ips; i++) {
+        /* Find the shared object and the function. */
+        const char * function = "[unknown]";
+        const char * object_name = "[unknown]";
+        bool section = false;
+        Dl_info info;
+        if (dladdr((void *) profile->ips[i], &info) && info.dli_fname) {
+            const char * slash = strrchr(info.dli_fname, '/');
+            object_name = slash ? slash+1 : info.dli_fname;
+            int j = 0;
+            for (; j < num_objects; j++) {
+                if (objects[j].base == (uintptr_t) info.dli_fbase)
+                    break;
+            }
+            if (j == num_objects) {
+                if (num_objects >= max_objects) {
+                    int n = max_objects ? 2 * max_objects : 16;
+                    struct elf_object * p = realloc(objects, n * sizeof(*p));
+                    if (!p)
+                        break;
+                    objects = p;
+                    max_objects = n;
+                }
+                elf_object_load(&objects[j], info.dli_fname,
+                                (uintptr_t) info.dli_fbase);
+                num_objects++;
+            }
+            bool in_section;
+            const char * name = elf_object_find(
+                &objects[j], profile->ips[i], &in_section);
+            if (name && !in_section) {
+                function = name;
+            } else if (info.dli_sname) {
+                function = info.dli_sname;
+            } else if (name) {
+                function = name;
+                section = true;
+            }
+        }
+
+        /* Count the sample. */
+        int j = 0;
+        for (; j < num_entries; j++) {
+            if (entries[j].section == section &&
+                strcmp(entries[j].function, function) == 0 &&
+                strcmp(entries[j].object, object_name) == 0)
+                break;
+        }
+        if (j == num_entries) {
+            if (num_entries >= max_entries) {
+                int n = max_entries ? 2 * max_entries : 64;
+                struct profile_entry * p = realloc(entries, n * sizeof(*p));
+                if (!p)
+                    break;
+                entries = p;
+                max_entries = n;
+            }
+            entries[j].function = function;
+            entries[j].object = object_name;
+            entries[j].section = section;
+            entries[j].count = 0;
+            num_entries++;
+        }
+        entries[j].count++;
+    }
+
+    qsort(entries, num_entries, sizeof(*entries), compare_profile_entries);
+    for (int j = 0; j < num_entries && j < max_functions; j++) {
+        fprintf(f, entries[j].section
+                ? "profile: %6.2f%% %8"PRId64" [%s] (%s)\n"
+                : "profile: %6.2f%% %8"PRId64" %s (%s)\n",
+                100.0 * entries[j].count / num_ips, entries[j].count,
+                entries[j].function, entries[j].object);
+    }
+    free(entries);
+    for (int j = 0; j < num_objects; j++)
+        elf_object_free(&objects[j]);
+    free(objects);
+}
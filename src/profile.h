@@ -0,0 +1,134 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Sampling profiler that attributes time to functions.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <pthread.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* The interval, in nanoseconds, between draining the ring buffers. */
+#define PROFILE_DRAIN_INTERVAL 100000000
+
+/**
+ * `profile_method` is used to enumerate ways of sampling the
+ * instruction pointer.
+ */
+enum profile_method
+{
+    profile_perf_cycles = 0, /* perf_event_open with the CPU cycle counter */
+    profile_perf_clock,      /* perf_event_open with the CPU clock */
+    profile_itimer,          /* setitimer with ITIMER_PROF and SIGPROF */
+
+    /* A final dummy entry, equal to the number of enum values. */
+    num_profile_methods
+};
+
+/**
+ * `profile_method_str()` is a string representing a given way of
+ * sampling the instruction pointer.
+ */
+const char * profile_method_str(
+    enum profile_method profile_method);
+
+/**
+ * `profile` is a set of instruction pointers sampled from the threads
+ * of a parallel region.
+ */
+struct profile
+{
+    enum profile_method method;
+    int frequency;
+    int num_threads;
+    int * fds;
+    void ** rings;
+    size_t ring_size;
+    uintptr_t * ips;
+    size_t max_ips;
+    atomic_size_t num_ips;
+    int64_t num_lost;
+
+    /* A thread that drains the ring buffers while sampling. */
+    pthread_t drainer;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stop;
+};
+
+/**
+ * `profile_start()` starts sampling the instruction pointer of each
+ * thread of a parallel region with `num_threads` threads, about
+ * `frequency` times per second.
+ *
+ * Each thread opens a sampling event for itself with
+ * `perf_event_open', counting CPU cycles or, if cycles are not
+ * available, CPU time. The samples are written to a ring buffer for
+ * each thread, and a separate thread drains the ring buffers every
+ * `PROFILE_DRAIN_INTERVAL` nanoseconds, so that long benchmarks do not
+ * overflow them. If `perf_event_open' is not permitted, then the
+ * process is sampled with `setitimer' instead, and a `SIGPROF'
+ * handler records the instruction pointer of the interrupted thread.
+ * Only one profile may be active at a time.
+ */
+int profile_start(
+    struct profile * profile,
+    int num_threads,
+    int frequency);
+
+/**
+ * `profile_stop()` stops sampling and collects the samples.
+ *
+ * Samples that did not fit in the ring buffers before they were
+ * drained, or that did not fit in the array of samples, are counted
+ * as lost.
+ */
+int profile_stop(
+    struct profile * profile);
+
+/**
+ * `profile_free()` frees resources associated with a profile.
+ */
+void profile_free(
+    struct profile * profile);
+
+/**
+ * `profile_print()` prints a flat profile with the `max_functions`
+ * functions that received the most samples.
+ *
+ * Each sample is attributed to a shared object with `dladdr()' and to
+ * a function with the ELF symbol table of the shared object, which
+ * also contains the local functions of libraries that are not
+ * stripped. The dynamic symbol table is used otherwise, and samples
+ * that do not belong to any known function are shown as an offset
+ * into the shared object.
+ */
+void profile_print(
+    const struct profile * profile,
+    int max_functions,
+    FILE * f);
+
+#endif
@@ -21,8 +21,15 @@
  */
 
 #include "program_options.h"
+#include "affinity.h"
+#include "arena.h"
+#include "corun.h"
 #include "mathop.h"
+#include "mempolicy.h"
+#include "monitor.h"
+#include "noise.h"
 #include "parse.h"
+#include "topology.h"
 
 #ifdef HAVE_MPFR
 #include <mpfr.h>
@@ -30,7 +37,6 @@
 
 #include <errno.h>
 
-#include <fenv.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -45,8 +51,20 @@ static int program_options_init(
 {
     args->filename = NULL;
     args->mathop = mathop_exp;
-    args->rounding_mode = fegetround();
+    args->rounding_mode = round_tonearest;
     args->alignment = sizeof(void *);
+    args->numa = mempolicy_default;
+    args->hugepages = hugepages_none;
+    args->prefault = false;
+    args->mlock = false;
+    args->bind.type = affinity_none;
+    args->bind.num_cpus = 0;
+    args->bind.cpus = NULL;
+    args->corun.num_tasks = 0;
+    args->corun.tasks = NULL;
+    args->noise.num_types = 0;
+    args->num_noise_cpus = 0;
+    args->noise_cpus = NULL;
     args->repeat = 1;
     args->min_ops = 0;
 #ifdef HAVE_MPFR
@@ -57,6 +75,28 @@ static int program_options_init(
     args->output_field_width = 0;
     args->output_precision = -1;
     args->verbose = 1;
+    args->omp_overhead = false;
+    args->fenv_overhead = false;
+    args->roofline = false;
+    args->baseline = false;
+    args->ab = false;
+    args->ab_mathop = mathop_exp;
+    args->ab_rounds = 30;
+    args->energy = false;
+    args->monitor_path = NULL;
+    args->monitor_format = monitor_csv;
+    args->monitor_interval = 1.0;
+    args->osnoise = false;
+    args->rt = false;
+    args->rt_priority = 50;
+    args->profile = false;
+    args->exceptions = exceptions_summary;
+    args->interval = false;
+    args->interval_block_size = 4096;
+    args->batch = false;
+    parse_batch_sizes("1,2,4,8,16,32,64", &args->batch_sizes);
+    args->dispatch = false;
+    args->replay_path = NULL;
     args->help = false;
     args->version = false;
     return 0;
@@ -71,6 +111,39 @@ void program_options_free(
 {
     if (args->filename)
         free(args->filename);
+    affinity_free(&args->bind);
+    corun_free(&args->corun);
+    free(args->noise_cpus);
+    free(args->monitor_path);
+    free(args->replay_path);
+}
+
+/**
+ * `parse_noise_cpus()` parses the list of CPUs that run background
+ * load.
+ */
+static int parse_noise_cpus(
+    const char * s,
+    struct program_options * args)
+{
+    int num_cpus;
+    int err = parse_cpulist(s, 0, NULL, &num_cpus);
+    if (err)
+        return err;
+    if (num_cpus <= 0)
+        return EINVAL;
+    int * cpus = malloc(num_cpus * sizeof(int));
+    if (!cpus)
+        return errno;
+    err = parse_cpulist(s, num_cpus, cpus, &num_cpus);
+    if (err) {
+        free(cpus);
+        return err;
+    }
+    free(args->noise_cpus);
+    args->noise_cpus = cpus;
+    args->num_noise_cpus = num_cpus;
+    return 0;
 }
 
 /**
@@ -93,11 +166,47 @@ void program_options_print_help(
     fprintf(f, "  --round=MODE\t\trounding mode: downward, tonearest, towardzero or\n");
     fprintf(f, "\t\t\tupward.\n");
     fprintf(f, "  --alignment=N\t\talignment in bytes of allocated memory (default: %ld)\n", sizeof(void *));
+    fprintf(f, "  --numa=POLICY\t\tNUMA placement of input and results: firsttouch,\n");
+    fprintf(f, "\t\t\tinterleave or local.\n");
+    fprintf(f, "  --hugepages=SIZE\tallocate input and results from a single arena\n");
+    fprintf(f, "\t\t\tbacked by huge pages: thp, 2M or 1G.\n");
+    fprintf(f, "  --prefault\t\ttouch all buffers before the benchmark\n");
+    fprintf(f, "  --mlock\t\tlock all buffers in memory\n");
+    fprintf(f, "  --bind=TYPE\t\tbind threads to CPUs: compact, scatter, cores, smt\n");
+    fprintf(f, "\t\t\tor a list of CPUs, such as list:0,2,4.\n");
+    fprintf(f, "  --corun=LIST\t\tbenchmark operations concurrently on given CPUs,\n");
+    fprintf(f, "\t\t\tsuch as exp@0,sqrt@1, and compare with solo runs.\n");
+    fprintf(f, "  --noise=LIST\t\tbenchmark under background load: stream, chase\n");
+    fprintf(f, "\t\t\tor fma, such as stream,fma.\n");
+    fprintf(f, "  --noise-cpus=LIST\tCPUs for background load (default: last CPU)\n");
     fprintf(f, "  --min-ops=N\t\trepeat until a minimum number of operations performed\n");
     fprintf(f, "  --repeat=N\t\trepeat benchmark\n");
     fprintf(f, "  --error-precision=N\tprecision to use when computing error\n");
     fprintf(f, "  --out-field-width=N\tfield width for output\n");
     fprintf(f, "  --out-precision=N\tprecision for output\n");
+    fprintf(f, "  --omp-overhead\t\tmeasure overhead of OpenMP constructs\n");
+    fprintf(f, "  --fenv-overhead\tmeasure overhead of floating-point environment calls\n");
+    fprintf(f, "  --roofline\t\tcompare with memory bandwidth and peak FMA rate\n");
+    fprintf(f, "  --baseline\t\tsubtract the cost of an identity copy and a call\n");
+    fprintf(f, "\t\t\tto an empty function\n");
+    fprintf(f, "  --ab=OP\t\tcompare with another operation in interleaved rounds\n");
+    fprintf(f, "  --ab-rounds=N\t\tnumber of rounds for --ab (default: 30)\n");
+    fprintf(f, "  --energy\t\tmeasure energy with RAPL counters\n");
+    fprintf(f, "  --monitor=FILE\t\twrite a time series of throughput to FILE\n");
+    fprintf(f, "  --monitor-format=FMT\ttime series format: csv or json (default: csv)\n");
+    fprintf(f, "  --monitor-interval=S\tseconds between samples (default: 1.0)\n");
+    fprintf(f, "  --osnoise\t\tprobe operating system noise on each CPU first\n");
+    fprintf(f, "  --rt[=PRIO]\t\tuse SCHED_FIFO at priority PRIO (default: 50),\n");
+    fprintf(f, "\t\t\tlock memory and isolate the benchmark threads\n");
+    fprintf(f, "  --profile\t\tsample the benchmark and print a flat profile\n");
+    fprintf(f, "  --exceptions=MODE\treport exceptions per thread (summary) or also\n");
+    fprintf(f, "\t\t\tclassify every result (detail) (default: summary)\n");
+    fprintf(f, "  --interval[=N]\t\tevaluate intervals under downward and upward\n");
+    fprintf(f, "\t\t\trounding in blocks of N elements (default: 4096)\n");
+    fprintf(f, "  --batch[=LIST]\t\ttime single-threaded calls on small batches of\n");
+    fprintf(f, "\t\t\telements (default: 1,2,4,8,16,32,64)\n");
+    fprintf(f, "  --dispatch\t\tcompare direct, indirect, PLT and inlined calls\n");
+    fprintf(f, "  --replay=FILE\t\treplay calls recorded by libmbench_trace.so\n");
     fprintf(f, "  -v, --verbose\t\tbe more verbose\n");
     fprintf(f, "  -q, --quiet\t\tsuppress output\n");
     fprintf(f, "\n");
@@ -239,6 +348,292 @@ int parse_program_options(
             continue;
         }
 
+        /* Parse NUMA memory placement policy. */
+        if (strcmp((*argv)[0], "--numa") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_mempolicy((*argv)[1], &args->numa);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--numa=") == (*argv)[0]) {
+            err = parse_mempolicy(
+                (*argv)[0] + strlen("--numa="), &args->numa);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse huge page size. */
+        if (strcmp((*argv)[0], "--hugepages") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_hugepages((*argv)[1], &args->hugepages);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--hugepages=") == (*argv)[0]) {
+            err = parse_hugepages(
+                (*argv)[0] + strlen("--hugepages="), &args->hugepages);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse options for prefaulting and locking memory. */
+        if (strcmp((*argv)[0], "--prefault") == 0) {
+            args->prefault = true;
+            num_arguments_consumed++;
+            continue;
+        }
+        if (strcmp((*argv)[0], "--mlock") == 0) {
+            args->mlock = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse thread binding. */
+        if (strcmp((*argv)[0], "--bind") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            affinity_free(&args->bind);
+            err = parse_affinity((*argv)[1], &args->bind);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--bind=") == (*argv)[0]) {
+            affinity_free(&args->bind);
+            err = parse_affinity(
+                (*argv)[0] + strlen("--bind="), &args->bind);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse concurrent math operations. */
+        if (strcmp((*argv)[0], "--corun") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            corun_free(&args->corun);
+            err = parse_corun((*argv)[1], &args->corun);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--corun=") == (*argv)[0]) {
+            corun_free(&args->corun);
+            err = parse_corun(
+                (*argv)[0] + strlen("--corun="), &args->corun);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse background load options. */
+        if (strcmp((*argv)[0], "--noise") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_noise_types((*argv)[1], &args->noise);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--noise=") == (*argv)[0]) {
+            err = parse_noise_types(
+                (*argv)[0] + strlen("--noise="), &args->noise);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+        if (strcmp((*argv)[0], "--noise-cpus") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_noise_cpus((*argv)[1], args);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--noise-cpus=") == (*argv)[0]) {
+            err = parse_noise_cpus(
+                (*argv)[0] + strlen("--noise-cpus="), args);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse interleaved A/B comparison options. */
+        if (strcmp((*argv)[0], "--ab") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_mathop((*argv)[1], &args->ab_mathop);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            args->ab = true;
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--ab=") == (*argv)[0]) {
+            err = parse_mathop(
+                (*argv)[0] + strlen("--ab="), &args->ab_mathop);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            args->ab = true;
+            num_arguments_consumed++;
+            continue;
+        }
+        if (strcmp((*argv)[0], "--ab-rounds") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_int32((*argv)[1], NULL, &args->ab_rounds, NULL);
+            if (err || args->ab_rounds < 2) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err ? err : EINVAL;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--ab-rounds=") == (*argv)[0]) {
+            err = parse_int32(
+                (*argv)[0] + strlen("--ab-rounds="), NULL, &args->ab_rounds, NULL);
+            if (err || args->ab_rounds < 2) {
+                program_options_free(args);
+                return err ? err : EINVAL;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse time series monitoring options. */
+        if (strcmp((*argv)[0], "--monitor") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            free(args->monitor_path);
+            args->monitor_path = strdup((*argv)[1]);
+            if (!args->monitor_path) {
+                program_options_free(args);
+                return errno;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--monitor=") == (*argv)[0]) {
+            free(args->monitor_path);
+            args->monitor_path = strdup((*argv)[0] + strlen("--monitor="));
+            if (!args->monitor_path) {
+                program_options_free(args);
+                return errno;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+        if (strcmp((*argv)[0], "--monitor-format") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_monitor_format((*argv)[1], &args->monitor_format);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--monitor-format=") == (*argv)[0]) {
+            err = parse_monitor_format(
+                (*argv)[0] + strlen("--monitor-format="), &args->monitor_format);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+        if (strcmp((*argv)[0], "--monitor-interval") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_double((*argv)[1], NULL, &args->monitor_interval, NULL);
+            if (err || !(args->monitor_interval > 0)) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err ? err : EINVAL;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--monitor-interval=") == (*argv)[0]) {
+            err = parse_double(
+                (*argv)[0] + strlen("--monitor-interval="), NULL,
+                &args->monitor_interval, NULL);
+            if (err || !(args->monitor_interval > 0)) {
+                program_options_free(args);
+                return err ? err : EINVAL;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
         /* Parse minimum number of operations. */
         if (strcmp((*argv)[0], "--min-ops") == 0) {
             if (*argc < 2) {
@@ -366,6 +761,164 @@ int parse_program_options(
             continue;
         }
 
+        /* Parse OpenMP overhead measurement option. */
+        if (strcmp((*argv)[0], "--omp-overhead") == 0) {
+            args->omp_overhead = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse floating-point environment overhead option. */
+        if (strcmp((*argv)[0], "--fenv-overhead") == 0) {
+            args->fenv_overhead = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse roofline option. */
+        if (strcmp((*argv)[0], "--roofline") == 0) {
+            args->roofline = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse baseline option. */
+        if (strcmp((*argv)[0], "--baseline") == 0) {
+            args->baseline = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse energy measurement option. */
+        if (strcmp((*argv)[0], "--energy") == 0) {
+            args->energy = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse operating system noise option. */
+        if (strcmp((*argv)[0], "--osnoise") == 0) {
+            args->osnoise = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse profiling option. */
+        if (strcmp((*argv)[0], "--profile") == 0) {
+            args->profile = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse exception reporting option. */
+        if (strcmp((*argv)[0], "--exceptions") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            err = parse_exceptions_mode((*argv)[1], &args->exceptions);
+            if (err) {
+                *num_error_args = 2;
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--exceptions=") == (*argv)[0]) {
+            err = parse_exceptions_mode(
+                (*argv)[0] + strlen("--exceptions="), &args->exceptions);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse interval evaluation option. */
+        if (strcmp((*argv)[0], "--interval") == 0) {
+            args->interval = true;
+            num_arguments_consumed++;
+            continue;
+        } else if (strstr((*argv)[0], "--interval=") == (*argv)[0]) {
+            err = parse_int64(
+                (*argv)[0] + strlen("--interval="), NULL,
+                &args->interval_block_size, NULL);
+            if (err || args->interval_block_size <= 0) {
+                program_options_free(args);
+                return err ? err : EINVAL;
+            }
+            args->interval = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse small-batch option. */
+        if (strcmp((*argv)[0], "--batch") == 0) {
+            args->batch = true;
+            num_arguments_consumed++;
+            continue;
+        } else if (strstr((*argv)[0], "--batch=") == (*argv)[0]) {
+            err = parse_batch_sizes(
+                (*argv)[0] + strlen("--batch="), &args->batch_sizes);
+            if (err) {
+                program_options_free(args);
+                return err;
+            }
+            args->batch = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse dispatch overhead option. */
+        if (strcmp((*argv)[0], "--dispatch") == 0) {
+            args->dispatch = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse trace replay option. */
+        if (strcmp((*argv)[0], "--replay") == 0) {
+            if (*argc < 2) {
+                program_options_free(args);
+                return EINVAL;
+            }
+            free(args->replay_path);
+            args->replay_path = strdup((*argv)[1]);
+            if (!args->replay_path) {
+                program_options_free(args);
+                return errno;
+            }
+            num_arguments_consumed += 2;
+            continue;
+        } else if (strstr((*argv)[0], "--replay=") == (*argv)[0]) {
+            free(args->replay_path);
+            args->replay_path = strdup((*argv)[0] + strlen("--replay="));
+            if (!args->replay_path) {
+                program_options_free(args);
+                return errno;
+            }
+            num_arguments_consumed++;
+            continue;
+        }
+
+        /* Parse real-time scheduling option. */
+        if (strcmp((*argv)[0], "--rt") == 0) {
+            args->rt = true;
+            num_arguments_consumed++;
+            continue;
+        } else if (strstr((*argv)[0], "--rt=") == (*argv)[0]) {
+            err = parse_int32(
+                (*argv)[0] + strlen("--rt="), NULL, &args->rt_priority, NULL);
+            if (err || args->rt_priority < 1 || args->rt_priority > 99) {
+                program_options_free(args);
+                return err ? err : EINVAL;
+            }
+            args->rt = true;
+            num_arguments_consumed++;
+            continue;
+        }
+
         if (strcmp((*argv)[0], "-v") == 0 || strcmp((*argv)[0], "--verbose") == 0) {
             args->verbose++;
             num_arguments_consumed++;
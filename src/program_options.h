@@ -23,7 +23,15 @@
 #ifndef PROGRAM_OPTIONS_H
 #define PROGRAM_OPTIONS_H
 
+#include "affinity.h"
+#include "arena.h"
+#include "batch.h"
+#include "corun.h"
+#include "fpclass.h"
 #include "mathop.h"
+#include "mempolicy.h"
+#include "monitor.h"
+#include "noise.h"
 #include "round.h"
 
 #include <stdbool.h>
@@ -46,12 +54,43 @@ struct program_options
     enum mathop mathop;
     enum round_mode rounding_mode;
     int alignment;
+    enum mempolicy numa;
+    enum hugepages hugepages;
+    bool prefault;
+    bool mlock;
+    struct affinity bind;
+    struct corun corun;
+    struct noise_types noise;
+    int num_noise_cpus;
+    int * noise_cpus;
     int repeat;
     int64_t min_ops;
     int error_precision;
     int output_field_width;
     int output_precision;
     int verbose;
+    bool omp_overhead;
+    bool fenv_overhead;
+    bool roofline;
+    bool baseline;
+    bool ab;
+    enum mathop ab_mathop;
+    int ab_rounds;
+    bool energy;
+    char * monitor_path;
+    enum monitor_format monitor_format;
+    double monitor_interval;
+    bool osnoise;
+    bool rt;
+    int rt_priority;
+    bool profile;
+    enum exceptions_mode exceptions;
+    bool interval;
+    int64_t interval_block_size;
+    bool batch;
+    struct batch_sizes batch_sizes;
+    bool dispatch;
+    char * replay_path;
     bool help;
     bool version;
 };
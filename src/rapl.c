@@ -0,0 +1,323 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Energy measurements from the RAPL interface of the powercap framework.
+ */
+
+#include "rapl.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef RAPL_PATH
+#define RAPL_PATH "/sys/class/powercap"
+#endif
+
+/**
+ * `read_uint64()` reads an unsigned integer from a file in sysfs.
+ */
+static int read_uint64(
+    const char * path,
+    uint64_t * value)
+{
+    FILE * f = fopen(path, "r");
+    if (!f)
+        return errno;
+    if (fscanf(f, "%"SCNu64, value) != 1) {
+        int err = ferror(f) ? errno : EINVAL;
+        fclose(f);
+        return err;
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * `read_name()` reads the name of a RAPL domain and prefixes it with
+ * the name of the parent package domain, if any.
+ */
+static int read_name(
+    const char * path,
+    const char * parent,
+    char * name,
+    size_t size)
+{
+    char buf[64];
+    char name_path[512];
+    snprintf(name_path, sizeof(name_path), "%s/name", path);
+    FILE * f = fopen(name_path, "r");
+    if (!f)
+        return errno;
+    if (!fgets(buf, sizeof(buf), f)) {
+        int err = ferror(f) ? errno : EINVAL;
+        fclose(f);
+        return err;
+    }
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    if (parent)
+        snprintf(name, size, "%s/%s", parent, buf);
+    else
+        snprintf(name, size, "%s", buf);
+    return 0;
+}
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `rapl_init()` finds the readable RAPL energy counters below
+ * `/sys/class/powercap'.
+ */
+int rapl_init(
+    struct rapl * rapl)
+{
+    rapl->num_domains = 0;
+    rapl->seconds = 0.0;
+    DIR * dir = opendir(RAPL_PATH);
+    if (!dir)
+        return ENOENT;
+
+    /*
+     * Package domains are named `intel-rapl:N', and their subdomains,
+     * such as the cores and DRAM, `intel-rapl:N:M'. Both appear
+     * directly below the powercap class directory.
+     */
+    bool found = false;
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL &&
+           rapl->num_domains < RAPL_MAX_DOMAINS)
+    {
+        unsigned int package, subdomain;
+        char end;
+        int n = sscanf(entry->d_name, "intel-rapl:%u:%u%c",
+                       &package, &subdomain, &end);
+        if (n != 1 && n != 2)
+            continue;
+        found = true;
+
+        struct rapl_domain * domain = &rapl->domains[rapl->num_domains];
+        snprintf(domain->path, sizeof(domain->path), "%s/%s",
+                 RAPL_PATH, entry->d_name);
+        char parent[64] = "";
+        if (n == 2) {
+            char parent_path[320];
+            snprintf(parent_path, sizeof(parent_path),
+                     "%s/intel-rapl:%u", RAPL_PATH, package);
+            if (read_name(parent_path, NULL, parent, sizeof(parent)))
+                snprintf(parent, sizeof(parent), "package-%u", package);
+        }
+        if (read_name(domain->path, n == 2 ? parent : NULL,
+                      domain->name, sizeof(domain->name)))
+            continue;
+
+        char path[384];
+        uint64_t energy_uj;
+        snprintf(path, sizeof(path), "%s/energy_uj", domain->path);
+        if (read_uint64(path, &energy_uj))
+            continue;
+        snprintf(path, sizeof(path), "%s/max_energy_range_uj", domain->path);
+        if (read_uint64(path, &domain->max_energy_range_uj))
+            domain->max_energy_range_uj = 0;
+        domain->joules = 0.0;
+        rapl->num_domains++;
+    }
+    closedir(dir);
+    if (!found)
+        return ENOENT;
+    if (rapl->num_domains == 0)
+        return EACCES;
+
+    /* Sort by name, so that subdomains follow their package. */
+    for (int i = 1; i < rapl->num_domains; i++) {
+        for (int j = i; j > 0 && strcmp(rapl->domains[j-1].name,
+                                        rapl->domains[j].name) > 0; j--) {
+            struct rapl_domain tmp = rapl->domains[j];
+            rapl->domains[j] = rapl->domains[j-1];
+            rapl->domains[j-1] = tmp;
+        }
+    }
+    return 0;
+}
+
+/**
+ * `rapl_sample()` reads the energy counters and adds their increments
+ * since the previous sample to the energy of each domain.
+ */
+static int rapl_sample(
+    struct rapl * rapl)
+{
+    for (int i = 0; i < rapl->num_domains; i++) {
+        struct rapl_domain * domain = &rapl->domains[i];
+        char path[384];
+        uint64_t uj;
+        snprintf(path, sizeof(path), "%s/energy_uj", domain->path);
+        int err = read_uint64(path, &uj);
+        if (err)
+            return err;
+        if (uj >= domain->last_uj) {
+            domain->energy_uj += uj - domain->last_uj;
+        } else if (domain->max_energy_range_uj > domain->last_uj) {
+            domain->energy_uj += uj + domain->max_energy_range_uj - domain->last_uj;
+        } else {
+            domain->valid = false;
+        }
+        domain->last_uj = uj;
+    }
+    return 0;
+}
+
+/**
+ * `rapl_sampler_main()` samples the energy counters every
+ * `RAPL_SAMPLE_INTERVAL` seconds until it is told to stop.
+ */
+static void * rapl_sampler_main(
+    void * arg)
+{
+    struct rapl * rapl = arg;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    pthread_mutex_lock(&rapl->mutex);
+    while (!rapl->stop) {
+        deadline.tv_sec += RAPL_SAMPLE_INTERVAL;
+        while (!rapl->stop &&
+               pthread_cond_timedwait(&rapl->cond, &rapl->mutex, &deadline) != ETIMEDOUT)
+            ;
+        if (!rapl->stop && !rapl->err)
+            rapl->err = rapl_sample(rapl);
+    }
+    pthread_mutex_unlock(&rapl->mutex);
+    return NULL;
+}
+
+/**
+ * `rapl_start()` reads the energy counters at the start of a
+ * measurement, and starts a thread that samples them every
+ * `RAPL_SAMPLE_INTERVAL` seconds.
+ */
+int rapl_start(
+    struct rapl * rapl)
+{
+    for (int i = 0; i < rapl->num_domains; i++) {
+        struct rapl_domain * domain = &rapl->domains[i];
+        char path[384];
+        snprintf(path, sizeof(path), "%s/energy_uj", domain->path);
+        int err = read_uint64(path, &domain->last_uj);
+        if (err)
+            return err;
+        domain->energy_uj = 0;
+        domain->valid = true;
+        domain->joules = 0.0;
+    }
+
+    /* The condition variable waits on the monotonic clock. */
+    pthread_condattr_t attr;
+    int err = pthread_condattr_init(&attr);
+    if (err)
+        return err;
+    err = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (!err)
+        err = pthread_cond_init(&rapl->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (err)
+        return err;
+    err = pthread_mutex_init(&rapl->mutex, NULL);
+    if (err) {
+        pthread_cond_destroy(&rapl->cond);
+        return err;
+    }
+    rapl->stop = false;
+    rapl->err = 0;
+    err = pthread_create(&rapl->sampler, NULL, rapl_sampler_main, rapl);
+    if (err) {
+        pthread_mutex_destroy(&rapl->mutex);
+        pthread_cond_destroy(&rapl->cond);
+        return err;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &rapl->t0);
+    return 0;
+}
+
+/**
+ * `rapl_stop()` stops sampling, reads the energy counters at the end
+ * of a measurement and computes the energy consumed by each domain.
+ */
+int rapl_stop(
+    struct rapl * rapl)
+{
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    rapl->seconds = timespec_duration(rapl->t0, t1);
+    pthread_mutex_lock(&rapl->mutex);
+    rapl->stop = true;
+    pthread_cond_signal(&rapl->cond);
+    pthread_mutex_unlock(&rapl->mutex);
+    pthread_join(rapl->sampler, NULL);
+    pthread_mutex_destroy(&rapl->mutex);
+    pthread_cond_destroy(&rapl->cond);
+
+    int err = rapl->err ? rapl->err : rapl_sample(rapl);
+    if (err)
+        return err;
+    for (int i = 0; i < rapl->num_domains; i++) {
+        struct rapl_domain * domain = &rapl->domains[i];
+        domain->joules = domain->energy_uj * 1e-6;
+    }
+    return 0;
+}
+
+/**
+ * `rapl_print()` prints the energy consumed by each domain, in
+ * joules per million operations and average watts.
+ */
+void rapl_print(
+    const struct rapl * rapl,
+    int64_t num_ops,
+    FILE * f)
+{
+    for (int i = 0; i < rapl->num_domains; i++) {
+        const struct rapl_domain * domain = &rapl->domains[i];
+        if (!domain->valid) {
+            fprintf(f, "%s%s: unknown (counter wrapped around with an "
+                    "unknown range)", i > 0 ? " " : "", domain->name);
+            continue;
+        }
+        fprintf(f, "%s%s: %.6f J %.6f J/Mop %.3f W",
+                i > 0 ? " " : "", domain->name, domain->joules,
+                num_ops > 0 ? domain->joules / (num_ops * 1e-6) : 0.0,
+                rapl->seconds > 0 ? domain->joules / rapl->seconds : 0.0);
+    }
+}
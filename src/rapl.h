@@ -0,0 +1,119 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Energy measurements from the RAPL interface of the powercap framework.
+ */
+
+#ifndef RAPL_H
+#define RAPL_H
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define RAPL_MAX_DOMAINS 32
+
+/*
+ * The interval, in seconds, at which the energy counters are sampled
+ * during a measurement, which must be shorter than the time it takes
+ * for a counter to wrap around.
+ */
+#define RAPL_SAMPLE_INTERVAL 1
+
+/**
+ * `rapl_domain` is an energy counter of a RAPL domain, such as a
+ * package, the cores of a package or the DRAM attached to it.
+ *
+ * `energy_uj` accumulates the increments of the counter between
+ * samples. If the counter wraps around, but its range is unknown, then
+ * the energy cannot be determined, and `valid` is false.
+ */
+struct rapl_domain
+{
+    char name[160];
+    char path[320];
+    uint64_t max_energy_range_uj;
+    uint64_t last_uj;
+    uint64_t energy_uj;
+    bool valid;
+    double joules;
+};
+
+/**
+ * `rapl` is a set of RAPL energy counters, which are sampled by a
+ * background thread during a measurement.
+ */
+struct rapl
+{
+    int num_domains;
+    struct rapl_domain domains[RAPL_MAX_DOMAINS];
+    struct timespec t0;
+    double seconds;
+
+    pthread_t sampler;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stop;
+    int err;
+};
+
+/**
+ * `rapl_init()` finds the readable RAPL energy counters below
+ * `/sys/class/powercap'.
+ *
+ * If there are no RAPL domains, then `ENOENT` is returned. If there
+ * are domains, but none of their counters can be read, which is the
+ * case for unprivileged users on recent kernels, then `EACCES` is
+ * returned.
+ */
+int rapl_init(
+    struct rapl * rapl);
+
+/**
+ * `rapl_start()` reads the energy counters at the start of a
+ * measurement, and starts a thread that samples them every
+ * `RAPL_SAMPLE_INTERVAL` seconds.
+ */
+int rapl_start(
+    struct rapl * rapl);
+
+/**
+ * `rapl_stop()` stops sampling, reads the energy counters at the end
+ * of a measurement and computes the energy consumed by each domain.
+ *
+ * A counter that is smaller than at the previous sample is assumed to
+ * have wrapped around once, at `max_energy_range_uj`. If that range
+ * is unknown, then the energy of the domain is not reported.
+ */
+int rapl_stop(
+    struct rapl * rapl);
+
+/**
+ * `rapl_print()` prints the energy consumed by each domain, in
+ * joules per million operations and average watts.
+ */
+void rapl_print(
+    const struct rapl * rapl,
+    int64_t num_ops,
+    FILE * f);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Page faults and context switches incurred by benchmark threads.
+ */
+
+#define _GNU_SOURCE
+
+#include "resource_usage.h"
+
+#include <errno.h>
+#include <sys/resource.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `resource_usage_thread()` obtains the page faults and context
+ * switches of the calling thread so far.
+ */
+int resource_usage_thread(
+    struct resource_usage * usage)
+{
+    struct rusage r;
+#ifdef RUSAGE_THREAD
+    if (getrusage(RUSAGE_THREAD, &r))
+        return errno;
+#else
+    return ENOTSUP;
+#endif
+    usage->minor_faults = r.ru_minflt;
+    usage->major_faults = r.ru_majflt;
+    usage->voluntary_context_switches = r.ru_nvcsw;
+    usage->involuntary_context_switches = r.ru_nivcsw;
+    return 0;
+}
+
+/**
+ * `resource_usage_sub()` computes the difference `a - b` between two
+ * resource usage counts and stores it in `a`.
+ */
+void resource_usage_sub(
+    struct resource_usage * a,
+    const struct resource_usage * b)
+{
+    a->minor_faults -= b->minor_faults;
+    a->major_faults -= b->major_faults;
+    a->voluntary_context_switches -= b->voluntary_context_switches;
+    a->involuntary_context_switches -= b->involuntary_context_switches;
+}
+
+/**
+ * `resource_usage_print()` prints page fault and context switch
+ * counts.
+ */
+void resource_usage_print(
+    const struct resource_usage * usage,
+    FILE * f)
+{
+    fprintf(f, "minor faults: %"PRId64" major faults: %"PRId64" "
+            "voluntary context switches: %"PRId64" "
+            "involuntary context switches: %"PRId64,
+            usage->minor_faults, usage->major_faults,
+            usage->voluntary_context_switches,
+            usage->involuntary_context_switches);
+}
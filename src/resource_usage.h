@@ -0,0 +1,66 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Page faults and context switches incurred by benchmark threads.
+ */
+
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `resource_usage` contains counts of page faults and context
+ * switches.
+ */
+struct resource_usage
+{
+    int64_t minor_faults;
+    int64_t major_faults;
+    int64_t voluntary_context_switches;
+    int64_t involuntary_context_switches;
+};
+
+/**
+ * `resource_usage_thread()` obtains the page faults and context
+ * switches of the calling thread so far.
+ *
+ * If `RUSAGE_THREAD` is not supported, then `ENOTSUP` is returned.
+ */
+int resource_usage_thread(
+    struct resource_usage * usage);
+
+/**
+ * `resource_usage_sub()` computes the difference `a - b` between two
+ * resource usage counts and stores it in `a`.
+ */
+void resource_usage_sub(
+    struct resource_usage * a,
+    const struct resource_usage * b);
+
+/**
+ * `resource_usage_print()` prints page fault and context switch
+ * counts.
+ */
+void resource_usage_print(
+    const struct resource_usage * usage,
+    FILE * f);
+
+#endif
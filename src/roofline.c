@@ -0,0 +1,213 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Memory bandwidth and peak floating-point ceilings for placing math
+ * operations on a roofline.
+ */
+
+#include "roofline.h"
+#include "fma.h"
+#include "mathop.h"
+#include "topology.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <errno.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `roofline_stream()` measures STREAM copy, scale and triad
+ * bandwidth.
+ */
+static int roofline_stream(
+    struct roofline * roofline,
+    int repeat)
+{
+    int64_t n = 4 * topology_llc_size() / sizeof(double);
+    double * a = malloc(n * sizeof(double));
+    double * b = malloc(n * sizeof(double));
+    double * c = malloc(n * sizeof(double));
+    if (!a || !b || !c) {
+        int err = errno;
+        free(c); free(b); free(a);
+        return err;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; i++) {
+        a[i] = 1.0;
+        b[i] = 2.0;
+        c[i] = 0.0;
+    }
+
+    const double s = 3.0;
+    struct timespec t0, t1;
+    double copy = 0.0, scale = 0.0, triad = 0.0;
+    for (int r = 0; r < repeat; r++) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < n; i++)
+            c[i] = a[i];
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double bandwidth = 2 * sizeof(double) * n / timespec_duration(t0, t1);
+        if (copy < bandwidth)
+            copy = bandwidth;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < n; i++)
+            b[i] = s * c[i];
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        bandwidth = 2 * sizeof(double) * n / timespec_duration(t0, t1);
+        if (scale < bandwidth)
+            scale = bandwidth;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < n; i++)
+            a[i] = b[i] + s * c[i];
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        bandwidth = 3 * sizeof(double) * n / timespec_duration(t0, t1);
+        if (triad < bandwidth)
+            triad = bandwidth;
+    }
+
+    /* Keep the compiler from removing the kernels. */
+    volatile double sink = a[n-1] + b[n-1] + c[n-1];
+    (void) sink;
+    free(c); free(b); free(a);
+    roofline->copy = copy;
+    roofline->scale = scale;
+    roofline->triad = triad;
+    return 0;
+}
+
+/**
+ * `roofline_fma()` measures the peak rate of fused multiply-adds.
+ */
+static int roofline_fma(
+    struct roofline * roofline,
+    int repeat)
+{
+    const int64_t iterations = 1 << 22;
+    struct timespec t0, t1;
+    double peak_flops = 0.0;
+    int num_threads = 1;
+    for (int r = 0; r < repeat; r++) {
+        double sum = 0.0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        #pragma omp parallel reduction(+:sum)
+        {
+#ifdef _OPENMP
+            #pragma omp single
+            num_threads = omp_get_num_threads();
+#endif
+            sum += fma_kernel(iterations);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        volatile double sink = sum;
+        (void) sink;
+        double flops = (double) num_threads * iterations *
+            fma_flops_per_iteration() / timespec_duration(t0, t1);
+        if (peak_flops < flops)
+            peak_flops = flops;
+    }
+    roofline->num_threads = num_threads;
+    roofline->peak_flops = peak_flops;
+    roofline->fma_kernel = fma_kernel_name();
+    return 0;
+}
+
+/**
+ * `roofline_measure()` measures STREAM copy, scale and triad
+ * bandwidth and the peak rate of fused multiply-adds with the
+ * threads of a parallel region.
+ */
+int roofline_measure(
+    struct roofline * roofline,
+    int repeat)
+{
+    int err = roofline_stream(roofline, repeat);
+    if (err)
+        return err;
+    return roofline_fma(roofline, repeat);
+}
+
+/**
+ * `roofline_print()` prints the bandwidth and floating-point
+ * ceilings.
+ */
+void roofline_print(
+    const struct roofline * roofline,
+    FILE * f)
+{
+    fprintf(f, "%d threads copy: %.3f GB/s scale: %.3f GB/s "
+            "triad: %.3f GB/s peak fma: %.3f Gflop/s (%s) "
+            "ridge point: %.3f flop/byte",
+            roofline->num_threads, roofline->copy * 1e-9,
+            roofline->scale * 1e-9, roofline->triad * 1e-9,
+            roofline->peak_flops * 1e-9, roofline->fma_kernel,
+            roofline->peak_flops / roofline->triad);
+}
+
+/**
+ * `roofline_print_mathop()` places a benchmarked math operation on
+ * the roofline.
+ */
+void roofline_print_mathop(
+    const struct roofline * roofline,
+    enum mathop mathop,
+    size_t input_type_size,
+    size_t result_type_size,
+    int64_t num_ops,
+    double seconds,
+    FILE * f)
+{
+    size_t bytes_per_op = input_type_size + result_type_size;
+    double ops_per_second = num_ops / seconds;
+    double bandwidth = ops_per_second * bytes_per_op;
+    double memory_ceiling = roofline->triad / bytes_per_op;
+    double flops_per_op = roofline->peak_flops / ops_per_second;
+    fprintf(f, "%s: %.3f GB/s %.3f Melem/s intensity: %.4f op/byte "
+            "memory ceiling: %.3f Mop/s (%.1f%% of triad) "
+            "fma budget: %.1f flop/op %s",
+            mathop_str(mathop), bandwidth * 1e-9, ops_per_second * 1e-6,
+            1.0 / bytes_per_op, memory_ceiling * 1e-6,
+            100.0 * bandwidth / roofline->triad, flops_per_op,
+            bandwidth >= 0.8 * roofline->triad ? "memory-bound" : "compute-bound");
+}
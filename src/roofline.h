@@ -0,0 +1,92 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Memory bandwidth and peak floating-point ceilings for placing math
+ * operations on a roofline.
+ */
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include "mathop.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * `roofline` contains the memory bandwidth and floating-point
+ * ceilings of the machine for a given number of threads.
+ */
+struct roofline
+{
+    int num_threads;
+    double copy;       /* STREAM copy, in bytes per second */
+    double scale;      /* STREAM scale, in bytes per second */
+    double triad;      /* STREAM triad, in bytes per second */
+    double peak_flops; /* fused multiply-adds, in flops per second */
+    const char * fma_kernel;
+};
+
+/**
+ * `roofline_measure()` measures STREAM copy, scale and triad
+ * bandwidth and the peak rate of fused multiply-adds with the
+ * threads of a parallel region.
+ *
+ * The STREAM arrays are four times larger than the last-level cache,
+ * and they are first touched with the same static partitioning as
+ * the kernels. Each measurement is repeated `repeat` times, and the
+ * best rate is kept.
+ */
+int roofline_measure(
+    struct roofline * roofline,
+    int repeat);
+
+/**
+ * `roofline_print()` prints the bandwidth and floating-point
+ * ceilings.
+ */
+void roofline_print(
+    const struct roofline * roofline,
+    FILE * f);
+
+/**
+ * `roofline_print_mathop()` places a benchmarked math operation on
+ * the roofline.
+ *
+ * Every operation reads one input element and writes one result
+ * element, so that the arithmetic intensity of an operation, in
+ * operations per byte, is the inverse of the sum of the input and
+ * result element sizes. The achieved bandwidth is compared with
+ * the triad bandwidth, and the floating-point budget per operation,
+ * that is, the number of flops that the FMA ceiling would allow in
+ * the time taken per operation, is reported. An operation that
+ * reaches at least 80% of the triad bandwidth is considered to be
+ * memory-bound.
+ */
+void roofline_print_mathop(
+    const struct roofline * roofline,
+    enum mathop mathop,
+    size_t input_type_size,
+    size_t result_type_size,
+    int64_t num_ops,
+    double seconds,
+    FILE * f);
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Real-time scheduling and isolation of the benchmark threads.
+ */
+
+#define _GNU_SOURCE
+
+#include "rt.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CGROUP_PATH
+#define CGROUP_PATH "/sys/fs/cgroup"
+#endif
+
+/**
+ * `write_file()` writes a string to a file, such as a cgroup control
+ * file.
+ */
+static int write_file(
+    const char * path,
+    const char * s)
+{
+    FILE * f = fopen(path, "w");
+    if (!f)
+        return errno;
+    if (fputs(s, f) == EOF) {
+        int err = errno;
+        fclose(f);
+        return err;
+    }
+    if (fclose(f))
+        return errno;
+    return 0;
+}
+
+/**
+ * `read_line()` reads the first line of a file, without the trailing
+ * newline.
+ */
+static int read_line(
+    const char * path,
+    char * buf,
+    size_t size)
+{
+    FILE * f = fopen(path, "r");
+    if (!f)
+        return errno;
+    if (!fgets(buf, size, f)) {
+        fclose(f);
+        return EIO;
+    }
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+/**
+ * `read_long()` reads an integer from the first line of a file, such
+ * as a kernel parameter.
+ */
+static int read_long(
+    const char * path,
+    long * value)
+{
+    char buf[64];
+    int err = read_line(path, buf, sizeof(buf));
+    if (err)
+        return err;
+    char * end;
+    errno = 0;
+    *value = strtol(buf, &end, 10);
+    if (errno)
+        return errno;
+    if (end == buf || *end != '\0')
+        return EINVAL;
+    return 0;
+}
+
+/**
+ * `cgroup_find()` finds the cgroup hierarchy that has the cpuset
+ * controller, and the cgroup of the calling process in it.
+ *
+ * With cgroup v1, the hierarchy is mounted at `cpuset' below
+ * `/sys/fs/cgroup'. With cgroup v2, there is a single, unified
+ * hierarchy, and the cpuset controller must be available in its root.
+ */
+static int cgroup_find(
+    char * root,
+    size_t root_size,
+    char * current,
+    size_t current_size,
+    bool * v1)
+{
+    FILE * f = fopen("/proc/self/cgroup", "r");
+    if (!f)
+        return errno;
+    char line[512];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+        char * controllers = strchr(line, ':');
+        char * path = controllers ? strchr(controllers+1, ':') : NULL;
+        if (!path)
+            continue;
+        *path++ = '\0';
+        controllers++;
+        if (*controllers == '\0') {
+            snprintf(root, root_size, "%s", CGROUP_PATH);
+            snprintf(current, current_size, "%s", path);
+            *v1 = false;
+        } else {
+            bool cpuset = false;
+            for (char * s = strtok(controllers, ","); s; s = strtok(NULL, ",")) {
+                if (strcmp(s, "cpuset") == 0)
+                    cpuset = true;
+            }
+            if (!cpuset)
+                continue;
+            snprintf(root, root_size, "%s/cpuset", CGROUP_PATH);
+            snprintf(current, current_size, "%s", path);
+            *v1 = true;
+            found = true;
+        }
+    }
+    fclose(f);
+
+    if (!found) {
+        /* Check that the unified hierarchy offers the cpuset controller. */
+        char path[384], controllers[256];
+        snprintf(path, sizeof(path), "%s/cgroup.controllers", root);
+        if (read_line(path, controllers, sizeof(controllers)) ||
+            !strstr(controllers, "cpuset"))
+            return ENOTSUP;
+    }
+    return 0;
+}
+
+/**
+ * `rt_cpuset()` moves the calling process into a new cgroup cpuset
+ * holding the given CPUs.
+ */
+static int rt_cpuset(
+    struct rt * rt,
+    const char * cpulist)
+{
+    char root[256], current[256];
+    bool v1 = false;
+    int err = cgroup_find(root, sizeof(root), current, sizeof(current), &v1);
+    if (err)
+        return err;
+    snprintf(rt->cpuset_parent, sizeof(rt->cpuset_parent), "%s%s",
+             root, strcmp(current, "/") == 0 ? "" : current);
+    snprintf(rt->cpuset_path, sizeof(rt->cpuset_path), "%s/mbench.%ld",
+             root, (long) getpid());
+
+    char path[544];
+    if (!v1) {
+        /* Enabling the controller may fail if it is already enabled. */
+        snprintf(path, sizeof(path), "%s/cgroup.subtree_control", root);
+        write_file(path, "+cpuset");
+    }
+    if (mkdir(rt->cpuset_path, 0755))
+        return errno;
+    snprintf(path, sizeof(path), "%s/cpuset.cpus", rt->cpuset_path);
+    err = write_file(path, cpulist);
+    if (!err && v1) {
+        /* Memory nodes must be set explicitly with cgroup v1. */
+        char mems[256];
+        snprintf(path, sizeof(path), "%s/cpuset.mems", root);
+        err = read_line(path, mems, sizeof(mems));
+        snprintf(path, sizeof(path), "%s/cpuset.mems", rt->cpuset_path);
+        if (!err)
+            err = write_file(path, mems);
+    }
+    if (!err) {
+        snprintf(path, sizeof(path), "%s/cgroup.procs", rt->cpuset_path);
+        err = write_file(path, "0");
+    }
+    if (err) {
+        rmdir(rt->cpuset_path);
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * `rt_enter()` isolates the threads of subsequent parallel regions.
+ */
+int rt_enter(
+    struct rt * rt,
+    int priority,
+    int num_threads,
+    const int * cpus)
+{
+    if (priority < sched_get_priority_min(SCHED_FIFO) ||
+        priority > sched_get_priority_max(SCHED_FIFO))
+        return EINVAL;
+    rt->num_threads = num_threads;
+    rt->priority = priority;
+    rt->fifo_err = 0;
+    rt->timerslack_err = 0;
+    rt->cpuset_path[0] = '\0';
+    rt->cpuset_parent[0] = '\0';
+
+    /* Scheduling policy and timer slack are set for each thread. */
+    int fifo_err = 0, timerslack_err = 0;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        struct sched_param param = {0};
+        param.sched_priority = priority;
+        int thread_err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (thread_err) {
+            #pragma omp critical
+            fifo_err = thread_err;
+        }
+        if (prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL)) {
+            thread_err = errno;
+            #pragma omp critical
+            timerslack_err = thread_err;
+        }
+    }
+    rt->fifo_err = fifo_err;
+    rt->timerslack_err = timerslack_err;
+
+    rt->mlock_err = mlockall(MCL_CURRENT | MCL_FUTURE) ? errno : 0;
+
+    /* List the CPUs of the cpuset. */
+    char cpulist[4096] = "";
+    size_t len = 0;
+    if (cpus) {
+        for (int i = 0; i < num_threads && len < sizeof(cpulist); i++)
+            len += snprintf(cpulist + len, sizeof(cpulist) - len,
+                            i > 0 ? ",%d" : "%d", cpus[i]);
+    } else {
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE && len < sizeof(cpulist); cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    len += snprintf(cpulist + len, sizeof(cpulist) - len,
+                                    len > 0 ? ",%d" : "%d", cpu);
+                }
+            }
+        }
+    }
+    rt->cpuset_err = len > 0 && len < sizeof(cpulist)
+        ? rt_cpuset(rt, cpulist) : EINVAL;
+    if (rt->cpuset_err)
+        rt->cpuset_path[0] = '\0';
+
+    /*
+     * Keep CPUs out of deep idle states, which also delays wakeups by
+     * timers, for as long as the file remains open.
+     */
+    rt->dma_latency_err = 0;
+    rt->dma_latency_fd = open("/dev/cpu_dma_latency", O_WRONLY);
+    if (rt->dma_latency_fd < 0) {
+        rt->dma_latency_err = errno;
+    } else {
+        int32_t latency = 0;
+        if (write(rt->dma_latency_fd, &latency, sizeof(latency)) != sizeof(latency)) {
+            rt->dma_latency_err = errno ? errno : EIO;
+            close(rt->dma_latency_fd);
+            rt->dma_latency_fd = -1;
+        }
+    }
+
+    /*
+     * Record the CPUs that the kernel keeps free of the scheduler tick
+     * and of other tasks, which can only be set at boot time.
+     */
+    if (read_line("/sys/devices/system/cpu/nohz_full",
+                  rt->nohz_full, sizeof(rt->nohz_full)))
+        rt->nohz_full[0] = '\0';
+    if (read_line("/sys/devices/system/cpu/isolated",
+                  rt->isolated, sizeof(rt->isolated)))
+        rt->isolated[0] = '\0';
+
+    /* Record the limits on the CPU time of real-time threads. */
+    if (read_long("/proc/sys/kernel/sched_rt_runtime_us", &rt->rt_runtime_us) ||
+        read_long("/proc/sys/kernel/sched_rt_period_us", &rt->rt_period_us)) {
+        rt->rt_runtime_us = 0;
+        rt->rt_period_us = 0;
+    }
+    return 0;
+}
+
+/**
+ * `rt_leave()` undoes the isolation steps that succeeded.
+ */
+void rt_leave(
+    struct rt * rt)
+{
+    if (!rt->mlock_err)
+        munlockall();
+    if (rt->dma_latency_fd >= 0) {
+        close(rt->dma_latency_fd);
+        rt->dma_latency_fd = -1;
+    }
+    if (rt->cpuset_path[0] != '\0') {
+        char path[544];
+        snprintf(path, sizeof(path), "%s/cgroup.procs", rt->cpuset_parent);
+        if (write_file(path, "0") == 0)
+            rmdir(rt->cpuset_path);
+    }
+    #pragma omp parallel num_threads(rt->num_threads)
+    {
+        struct sched_param param = {0};
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        prctl(PR_SET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL);
+    }
+}
+
+/**
+ * `rt_print_step()` prints whether an isolation step succeeded.
+ */
+static void rt_print_step(
+    const char * step,
+    int err,
+    FILE * f)
+{
+    if (err)
+        fprintf(f, "%s: no (%s)", step, strerror(err));
+    else
+        fprintf(f, "%s: yes", step);
+}
+
+/**
+ * `rt_print()` prints which isolation steps succeeded.
+ */
+void rt_print(
+    const struct rt * rt,
+    FILE * f)
+{
+    char step[320];
+    snprintf(step, sizeof(step), "SCHED_FIFO priority %d", rt->priority);
+    rt_print_step(step, rt->fifo_err, f);
+    rt_print_step(" mlock", rt->mlock_err, f);
+    if (rt->cpuset_err) {
+        rt_print_step(" cpuset", rt->cpuset_err, f);
+    } else {
+        snprintf(step, sizeof(step), " cpuset %s", rt->cpuset_path);
+        rt_print_step(step, 0, f);
+    }
+    rt_print_step(" timer slack 1 ns", rt->timerslack_err, f);
+    rt_print_step(" cpu_dma_latency 0", rt->dma_latency_err, f);
+    fprintf(f, " nohz_full: %s isolated: %s",
+            rt->nohz_full[0] ? rt->nohz_full : "none",
+            rt->isolated[0] ? rt->isolated : "none");
+    if (rt->rt_period_us > 0) {
+        fprintf(f, " sched_rt_runtime_us: %ld sched_rt_period_us: %ld",
+                rt->rt_runtime_us, rt->rt_period_us);
+    } else {
+        fprintf(f, " sched_rt_runtime_us: unknown");
+    }
+}
+
+/**
+ * `rt_throttled()` is true if real-time threads may be throttled.
+ */
+bool rt_throttled(
+    const struct rt * rt)
+{
+    return rt->rt_period_us > 0 && rt->rt_runtime_us != -1;
+}
@@ -0,0 +1,99 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Real-time scheduling and isolation of the benchmark threads.
+ */
+
+#ifndef RT_H
+#define RT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * `rt` records the steps taken to isolate the benchmark threads from
+ * other work, and whether each step succeeded. An error of zero means
+ * that the step succeeded.
+ */
+struct rt
+{
+    int num_threads;
+    int priority;
+    int fifo_err;
+    int mlock_err;
+    int cpuset_err;
+    char cpuset_path[288];
+    char cpuset_parent[520];
+    int timerslack_err;
+    int dma_latency_err;
+    int dma_latency_fd;
+    char nohz_full[256];
+    char isolated[256];
+    long rt_runtime_us;
+    long rt_period_us;
+};
+
+/**
+ * `rt_enter()` isolates the threads of subsequent parallel regions.
+ *
+ * Each of `num_threads` threads is scheduled with `SCHED_FIFO` at the
+ * given priority and its timer slack is reduced to one nanosecond, so
+ * that timers are not coalesced with the benchmark. All memory is
+ * locked. The process is moved into a dedicated cgroup cpuset holding
+ * the CPUs in `cpus`, or the CPUs that the process may currently run
+ * on if `cpus` is `NULL`. Finally, `/dev/cpu_dma_latency' is held at
+ * zero to keep CPUs out of deep idle states.
+ *
+ * The limits on the CPU time of real-time threads are recorded from
+ * `/proc/sys/kernel/sched_rt_runtime_us' and `sched_rt_period_us',
+ * since `SCHED_FIFO' threads are throttled for the rest of each period
+ * once they have run for the runtime, unless the runtime is -1. If
+ * the limits cannot be read, both are recorded as zero.
+ *
+ * Each step is attempted even if an earlier one fails, since most of
+ * them require privileges. The outcome of each step is recorded in
+ * `rt`, and `rt_enter()` only fails if a priority is out of range.
+ */
+int rt_enter(
+    struct rt * rt,
+    int priority,
+    int num_threads,
+    const int * cpus);
+
+/**
+ * `rt_leave()` undoes the isolation steps that succeeded.
+ */
+void rt_leave(
+    struct rt * rt);
+
+/**
+ * `rt_print()` prints which isolation steps succeeded.
+ */
+void rt_print(
+    const struct rt * rt,
+    FILE * f);
+
+/**
+ * `rt_throttled()` is true if real-time threads may be throttled,
+ * that is, if the real-time runtime limit is known and not -1.
+ */
+bool rt_throttled(
+    const struct rt * rt);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Statistics for comparing repeated measurements.
+ */
+
+#include "stats.h"
+
+#include <errno.h>
+
+#include <math.h>
+
+/**
+ * `student_t_975()` is the 97.5% quantile of Student's
+ * t-distribution with the given number of degrees of freedom.
+ */
+double student_t_975(
+    int degrees_of_freedom)
+{
+    static const double t[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degrees_of_freedom < 1)
+        return INFINITY;
+    if (degrees_of_freedom <= 30)
+        return t[degrees_of_freedom-1];
+    if (degrees_of_freedom <= 60)
+        return 2.000;
+    if (degrees_of_freedom <= 120)
+        return 1.980;
+    return 1.960;
+}
+
+/**
+ * `paired_ratio()` computes the ratio `a[i] / b[i]` of each pair of
+ * measurements and summarises the ratios.
+ */
+int paired_ratio(
+    int num_pairs,
+    const double * a,
+    const double * b,
+    struct ratio_stats * stats)
+{
+    if (num_pairs < 2)
+        return EINVAL;
+    double sum = 0.0;
+    stats->min = INFINITY;
+    stats->max = 0.0;
+    for (int i = 0; i < num_pairs; i++) {
+        if (!(a[i] > 0) || !(b[i] > 0))
+            return EINVAL;
+        double ratio = a[i] / b[i];
+        if (stats->min > ratio)
+            stats->min = ratio;
+        if (stats->max < ratio)
+            stats->max = ratio;
+        sum += log(ratio);
+    }
+    double mean = sum / num_pairs;
+    double sum_squares = 0.0;
+    for (int i = 0; i < num_pairs; i++) {
+        double d = log(a[i] / b[i]) - mean;
+        sum_squares += d * d;
+    }
+    double stderror = sqrt(sum_squares / (num_pairs - 1) / num_pairs);
+    double half_width = student_t_975(num_pairs - 1) * stderror;
+    stats->num_ratios = num_pairs;
+    stats->geomean = exp(mean);
+    stats->lower = exp(mean - half_width);
+    stats->upper = exp(mean + half_width);
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Statistics for comparing repeated measurements.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+/**
+ * `student_t_975()` is the 97.5% quantile of Student's
+ * t-distribution with the given number of degrees of freedom, which
+ * is used for two-sided 95% confidence intervals.
+ */
+double student_t_975(
+    int degrees_of_freedom);
+
+/**
+ * `ratio_stats` summarises a set of paired ratios.
+ */
+struct ratio_stats
+{
+    int num_ratios;
+    double geomean; /* geometric mean of the ratios */
+    double lower;   /* lower end of the 95% confidence interval */
+    double upper;   /* upper end of the 95% confidence interval */
+    double min;
+    double max;
+};
+
+/**
+ * `paired_ratio()` computes the ratio `a[i] / b[i]` of each pair of
+ * measurements and summarises the ratios.
+ *
+ * The confidence interval is obtained from Student's t-distribution
+ * for the mean of the logarithms of the ratios, which is transformed
+ * back to a ratio. Since every pair is measured close together in
+ * time, drift that affects both measurements of a pair cancels out.
+ *
+ * At least two pairs are needed for a confidence interval, and all
+ * measurements must be positive. Otherwise, `EINVAL` is returned.
+ */
+int paired_ratio(
+    int num_pairs,
+    const double * a,
+    const double * b,
+    struct ratio_stats * stats);
+
+#endif
@@ -0,0 +1,304 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * CPU topology, as described by `/sys/devices/system/cpu'.
+ */
+
+#include "topology.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * `parse_cpulist()` parses a list of CPUs in the format used by the
+ * kernel, such as `0-3,8,10-11'.
+ */
+int parse_cpulist(
+    const char * s,
+    int max_cpus,
+    int * cpus,
+    int * num_cpus)
+{
+    int n = 0;
+    while (*s != '\0' && *s != '\n') {
+        char * end;
+        errno = 0;
+        long first = strtol(s, &end, 10);
+        if (end == s || errno || first < 0)
+            return EINVAL;
+        long last = first;
+        s = end;
+        if (*s == '-') {
+            s++;
+            last = strtol(s, &end, 10);
+            if (end == s || errno || last < first)
+                return EINVAL;
+            s = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++, n++) {
+            if (n < max_cpus)
+                cpus[n] = cpu;
+        }
+        if (*s == ',')
+            s++;
+        else if (*s != '\0' && *s != '\n')
+            return EINVAL;
+    }
+    *num_cpus = n;
+    return 0;
+}
+
+/**
+ * `read_sysfs()` reads the first line of a file in sysfs.
+ */
+static int read_sysfs(
+    const char * path,
+    char * buf,
+    size_t size)
+{
+    FILE * f = fopen(path, "r");
+    if (!f)
+        return errno;
+    if (!fgets(buf, size, f)) {
+        int err = ferror(f) ? errno : EIO;
+        fclose(f);
+        return err;
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * `read_sysfs_int()` reads an integer from a file in sysfs.
+ */
+static int read_sysfs_int(
+    const char * path,
+    int * value)
+{
+    char buf[64];
+    int err = read_sysfs(path, buf, sizeof(buf));
+    if (err)
+        return err;
+    if (sscanf(buf, "%d", value) != 1)
+        return EINVAL;
+    return 0;
+}
+
+/**
+ * `read_sysfs_cpulist()` reads a list of CPUs from a file in sysfs.
+ *
+ * The list is allocated with `malloc()`, and it must be freed by the
+ * caller.
+ */
+static int read_sysfs_cpulist(
+    const char * path,
+    int ** cpus,
+    int * num_cpus)
+{
+    /* Lists of CPU ranges are short, even for large systems. */
+    char buf[4096];
+    int err = read_sysfs(path, buf, sizeof(buf));
+    if (err)
+        return err;
+    err = parse_cpulist(buf, 0, NULL, num_cpus);
+    if (err)
+        return err;
+    *cpus = malloc((*num_cpus > 0 ? *num_cpus : 1) * sizeof(int));
+    if (!*cpus)
+        return errno;
+    return parse_cpulist(buf, *num_cpus, *cpus, num_cpus);
+}
+
+/**
+ * `topology_cpu_init()` reads the package, core, SMT sibling and
+ * cache information for a logical CPU.
+ */
+static void topology_cpu_init(
+    struct topology_cpu * c,
+    int cpu)
+{
+    char path[256];
+    c->cpu = cpu;
+    c->package = 0;
+    c->core = cpu;
+    c->thread = 0;
+    c->l2 = -1;
+    c->l3 = -1;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    read_sysfs_int(path, &c->package);
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+    read_sysfs_int(path, &c->core);
+
+    /* The position among the SMT siblings of the core. */
+    int * siblings;
+    int num_siblings;
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    if (!read_sysfs_cpulist(path, &siblings, &num_siblings)) {
+        for (int i = 0; i < num_siblings; i++) {
+            if (siblings[i] == cpu)
+                c->thread = i;
+        }
+        free(siblings);
+    }
+
+    /* The lowest CPU sharing each level of unified or data cache. */
+    for (int index = 0; ; index++) {
+        int level;
+        char type[64];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        if (read_sysfs_int(path, &level))
+            break;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+        if (read_sysfs(path, type, sizeof(type)) ||
+            strncmp(type, "Instruction", strlen("Instruction")) == 0)
+            continue;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+                 cpu, index);
+        int * shared;
+        int num_shared;
+        if (read_sysfs_cpulist(path, &shared, &num_shared))
+            continue;
+        if (num_shared > 0 && level == 2)
+            c->l2 = shared[0];
+        else if (num_shared > 0 && level == 3)
+            c->l3 = shared[0];
+        free(shared);
+    }
+}
+
+/**
+ * `topology_init()` discovers the topology of the online CPUs by
+ * reading `/sys/devices/system/cpu'.
+ */
+int topology_init(
+    struct topology * topology)
+{
+    int * online;
+    int num_online;
+    int err = read_sysfs_cpulist(
+        "/sys/devices/system/cpu/online", &online, &num_online);
+    if (err)
+        return err;
+
+    topology->cpus = malloc(
+        (num_online > 0 ? num_online : 1) * sizeof(struct topology_cpu));
+    if (!topology->cpus) {
+        free(online);
+        return errno;
+    }
+    topology->num_cpus = num_online;
+    for (int i = 0; i < num_online; i++)
+        topology_cpu_init(&topology->cpus[i], online[i]);
+    free(online);
+
+    /* Count distinct packages, cores and caches. */
+    topology->num_packages = 0;
+    topology->num_cores = 0;
+    topology->num_l2 = 0;
+    topology->num_l3 = 0;
+    for (int i = 0; i < topology->num_cpus; i++) {
+        const struct topology_cpu * c = &topology->cpus[i];
+        bool new_package = true, new_core = true;
+        bool new_l2 = c->l2 >= 0, new_l3 = c->l3 >= 0;
+        for (int j = 0; j < i; j++) {
+            const struct topology_cpu * d = &topology->cpus[j];
+            if (d->package == c->package) {
+                new_package = false;
+                if (d->core == c->core)
+                    new_core = false;
+            }
+            if (d->l2 == c->l2)
+                new_l2 = false;
+            if (d->l3 == c->l3)
+                new_l3 = false;
+        }
+        topology->num_packages += new_package;
+        topology->num_cores += new_core;
+        topology->num_l2 += new_l2;
+        topology->num_l3 += new_l3;
+    }
+    return 0;
+}
+
+/**
+ * `topology_free()` frees resources associated with a CPU topology.
+ */
+void topology_free(
+    struct topology * topology)
+{
+    free(topology->cpus);
+    topology->cpus = NULL;
+    topology->num_cpus = 0;
+}
+
+/**
+ * `topology_find_cpu()` returns the description of a logical CPU, or
+ * `NULL` if the CPU is not online.
+ */
+const struct topology_cpu * topology_find_cpu(
+    const struct topology * topology,
+    int cpu)
+{
+    for (int i = 0; i < topology->num_cpus; i++) {
+        if (topology->cpus[i].cpu == cpu)
+            return &topology->cpus[i];
+    }
+    return NULL;
+}
+
+/**
+ * `topology_print()` prints a summary of a CPU topology.
+ */
+void topology_print(
+    const struct topology * topology,
+    FILE * f)
+{
+    fprintf(f, "%d packages %d cores %d cpus %d L2 caches %d L3 caches",
+            topology->num_packages, topology->num_cores, topology->num_cpus,
+            topology->num_l2, topology->num_l3);
+}
+
+/**
+ * `topology_llc_size()` is the size in bytes of the last-level cache
+ * of a CPU, or 8 MiB if it is not known.
+ */
+size_t topology_llc_size(void)
+{
+    long size = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    if (size <= 0)
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return size > 0 ? size : 8 * 1024 * 1024;
+}
@@ -0,0 +1,105 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * CPU topology, as described by `/sys/devices/system/cpu'.
+ */
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * `topology_cpu` describes the location of a logical CPU within the
+ * packages, cores and caches of the system.
+ */
+struct topology_cpu
+{
+    int cpu;     /* logical CPU number */
+    int package; /* physical package (socket) */
+    int core;    /* core within the package */
+    int thread;  /* index among the SMT siblings of the core */
+    int l2;      /* lowest CPU sharing the L2 cache, or -1 */
+    int l3;      /* lowest CPU sharing the L3 cache, or -1 */
+};
+
+/**
+ * `topology` describes the online CPUs of the system.
+ */
+struct topology
+{
+    int num_cpus;
+    struct topology_cpu * cpus;
+    int num_packages;
+    int num_cores;
+    int num_l2;
+    int num_l3;
+};
+
+/**
+ * `topology_init()` discovers the topology of the online CPUs by
+ * reading `/sys/devices/system/cpu'.
+ */
+int topology_init(
+    struct topology * topology);
+
+/**
+ * `topology_free()` frees resources associated with a CPU topology.
+ */
+void topology_free(
+    struct topology * topology);
+
+/**
+ * `topology_find_cpu()` returns the description of a logical CPU, or
+ * `NULL` if the CPU is not online.
+ */
+const struct topology_cpu * topology_find_cpu(
+    const struct topology * topology,
+    int cpu);
+
+/**
+ * `topology_print()` prints a summary of a CPU topology.
+ */
+void topology_print(
+    const struct topology * topology,
+    FILE * f);
+
+/**
+ * `topology_llc_size()` is the size in bytes of the last-level cache
+ * of a CPU, or 8 MiB if it is not known.
+ */
+size_t topology_llc_size(void);
+
+/**
+ * `parse_cpulist()` parses a list of CPUs in the format used by the
+ * kernel, such as `0-3,8,10-11'.
+ *
+ * At most `max_cpus` CPUs are stored in `cpus`, and the number of
+ * CPUs in the list is stored in `num_cpus`. On success,
+ * `parse_cpulist()` returns `0`. Otherwise, if the list is invalid,
+ * `parse_cpulist()` returns `EINVAL`.
+ */
+int parse_cpulist(
+    const char * s,
+    int max_cpus,
+    int * cpus,
+    int * num_cpus);
+
+#endif
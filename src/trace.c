@@ -0,0 +1,314 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Traces of calls to math functions, and their replay.
+ */
+
+#include "trace.h"
+#include "mathop.h"
+#include "round.h"
+
+#include <errno.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * `trace_read()` reads a trace from a file.
+ */
+int trace_read(
+    const char * path,
+    struct trace * trace)
+{
+    FILE * f = fopen(path, "rb");
+    if (!f)
+        return errno;
+    struct trace_header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        header.version != TRACE_VERSION ||
+        header.num_mathops != num_mathops)
+    {
+        fclose(f);
+        return EINVAL;
+    }
+
+    int64_t capacity = 4096;
+    struct trace_record * records = malloc(capacity * sizeof(*records));
+    if (!records) {
+        int err = errno;
+        fclose(f);
+        return err;
+    }
+    int64_t num_records = 0;
+    uint32_t max_thread = 0;
+    while (true) {
+        if (num_records == capacity) {
+            capacity *= 2;
+            struct trace_record * p = realloc(records, capacity * sizeof(*records));
+            if (!p) {
+                int err = errno;
+                free(records);
+                fclose(f);
+                return err;
+            }
+            records = p;
+        }
+        size_t n = fread(&records[num_records], sizeof(*records),
+                         capacity - num_records, f);
+        for (size_t i = 0; i < n; i++) {
+            const struct trace_record * r = &records[num_records+i];
+            if (r->mathop >= num_mathops) {
+                free(records);
+                fclose(f);
+                return EINVAL;
+            }
+            if (max_thread < r->thread)
+                max_thread = r->thread;
+        }
+        num_records += n;
+        if (num_records < capacity)
+            break;
+    }
+    int err = ferror(f) ? EIO : 0;
+    fclose(f);
+    if (err) {
+        free(records);
+        return err;
+    }
+    trace->period = header.period;
+    trace->num_dropped = header.num_dropped;
+    trace->num_threads = num_records > 0 ? max_thread + 1 : 0;
+    trace->num_records = num_records;
+    trace->records = records;
+    return 0;
+}
+
+/**
+ * `trace_free()` frees resources associated with a trace.
+ */
+void trace_free(
+    struct trace * trace)
+{
+    free(trace->records);
+    trace->records = NULL;
+    trace->num_records = 0;
+}
+
+/**
+ * `trace_call()` calls the math function of a recorded call.
+ */
+static double trace_call(
+    enum mathop mathop,
+    double x)
+{
+#define trace_call_double(OPNAME) case mathop_ ## OPNAME: return OPNAME(x)
+#define trace_call_float(OPNAME) case mathop_ ## OPNAME: return OPNAME((float) x)
+    switch (mathop) {
+    trace_call_double(cos); trace_call_float(cosf);
+    trace_call_double(sin); trace_call_float(sinf);
+    trace_call_double(tan); trace_call_float(tanf);
+    trace_call_double(acos); trace_call_float(acosf);
+    trace_call_double(asin); trace_call_float(asinf);
+    trace_call_double(atan); trace_call_float(atanf);
+    trace_call_double(cosh); trace_call_float(coshf);
+    trace_call_double(sinh); trace_call_float(sinhf);
+    trace_call_double(tanh); trace_call_float(tanhf);
+    trace_call_double(acosh); trace_call_float(acoshf);
+    trace_call_double(asinh); trace_call_float(asinhf);
+    trace_call_double(atanh); trace_call_float(atanhf);
+    trace_call_double(exp); trace_call_float(expf);
+    trace_call_double(log); trace_call_float(logf);
+    trace_call_double(log10); trace_call_float(log10f);
+    trace_call_double(exp2); trace_call_float(exp2f);
+    trace_call_double(expm1); trace_call_float(expm1f);
+    trace_call_double(log1p); trace_call_float(log1pf);
+    trace_call_double(log2); trace_call_float(log2f);
+    trace_call_double(sqrt); trace_call_float(sqrtf);
+    trace_call_double(cbrt); trace_call_float(cbrtf);
+    trace_call_double(erf); trace_call_float(erff);
+    trace_call_double(erfc); trace_call_float(erfcf);
+    trace_call_double(tgamma); trace_call_float(tgammaf);
+    trace_call_double(lgamma); trace_call_float(lgammaf);
+    default: return 0.0;
+    }
+#undef trace_call_float
+#undef trace_call_double
+}
+
+/**
+ * `timespec_duration()` is the duration, in seconds, elapsed between
+ * two given time points.
+ */
+static double timespec_duration(
+    struct timespec t0,
+    struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) +
+        (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * `trace_replay_mathop()` benchmarks and checks the accuracy of one
+ * math operation for the arguments of its recorded calls.
+ */
+static int trace_replay_mathop(
+    const struct trace * trace,
+    enum mathop mathop,
+    int alignment,
+    int repeat,
+    enum round_mode rounding_mode,
+    int precision,
+    struct trace_replay_op * op)
+{
+    struct mathop_input values = {0};
+    values.type = mathop_input_f64;
+    values.size = op->num_calls;
+    values.f64 = malloc(op->num_calls * sizeof(double));
+    if (!values.f64)
+        return errno;
+    int64_t n = 0;
+    for (int64_t i = 0; i < trace->num_records; i++) {
+        if (trace->records[i].mathop == mathop)
+            values.f64[n++] = trace->records[i].x;
+    }
+
+    struct mathop_input input;
+    int err = mathop_input_copy(&input, mathop, &values, alignment);
+    free(values.f64);
+    if (err)
+        return err;
+    struct mathop_result result;
+    err = mathop_result_init(&result, mathop, input.size, alignment);
+    if (err) {
+        mathop_input_free(&input);
+        return err;
+    }
+
+    /*
+     * Domain and range errors are expected, since the arguments are
+     * those of real applications, and are not reported.
+     */
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < repeat; i++) {
+        #pragma omp parallel
+        {
+            int64_t thread_ops = 0;
+            benchmark_mathop(mathop, &input, &result, &thread_ops);
+            #pragma omp master
+            op->num_ops += thread_ops;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    op->seconds = timespec_duration(t0, t1);
+
+    const char * exceptions;
+    err = mathop_error(
+        mathop, &input, &result, rounding_mode, precision,
+        &op->abs_error, &op->rel_error, &exceptions);
+    op->have_error = !err;
+    mathop_result_free(&result);
+    mathop_input_free(&input);
+    return err == ENOTSUP ? 0 : err;
+}
+
+/**
+ * `trace_replay()` replays the calls in a trace.
+ */
+int trace_replay(
+    const struct trace * trace,
+    int alignment,
+    int repeat,
+    enum round_mode rounding_mode,
+    int precision,
+    struct trace_replay_result * result)
+{
+    if (repeat < 1)
+        repeat = 1;
+    memset(result, 0, sizeof(*result));
+    result->repeat = repeat;
+    for (int64_t i = 0; i < trace->num_records; i++)
+        result->ops[trace->records[i].mathop].num_calls++;
+
+    /* Replay the mix of calls in the recorded order. */
+    volatile double sink;
+    double sum = 0.0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < repeat; i++) {
+        for (int64_t j = 0; j < trace->num_records; j++)
+            sum += trace_call(trace->records[j].mathop, trace->records[j].x);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    sink = sum;
+    (void) sink;
+    result->num_calls = repeat * trace->num_records;
+    result->seconds = timespec_duration(t0, t1);
+
+    for (int m = 0; m < num_mathops; m++) {
+        if (result->ops[m].num_calls == 0)
+            continue;
+        int err = trace_replay_mathop(
+            trace, m, alignment, repeat, rounding_mode, precision,
+            &result->ops[m]);
+        if (err)
+            return err;
+    }
+    return 0;
+}
+
+/**
+ * `trace_replay_print()` prints the throughput of the mix of calls in
+ * a trace, and the share of calls, throughput and error of each math
+ * operation.
+ */
+void trace_replay_print(
+    const struct trace * trace,
+    const struct trace_replay_result * result,
+    FILE * f)
+{
+    fprintf(f, "replay: %"PRId64" calls from %d threads "
+            "(1 in %"PRIu64" sampled, %"PRIu64" dropped) "
+            "mix: %.6f seconds %d repetitions %.6f Mcalls/s\n",
+            trace->num_records, trace->num_threads, trace->period,
+            trace->num_dropped, result->seconds, result->repeat,
+            result->seconds > 0
+            ? (double) result->num_calls / result->seconds / 1000000.0 : 0.0);
+    for (int m = 0; m < num_mathops; m++) {
+        const struct trace_replay_op * op = &result->ops[m];
+        if (op->num_calls == 0)
+            continue;
+        fprintf(f, "replay: %s %"PRId64" calls (%.1f%%): %.6f Mops/s",
+                mathop_str(m), op->num_calls,
+                100.0 * op->num_calls / trace->num_records,
+                op->seconds > 0 ? (double) op->num_ops / op->seconds / 1000000.0 : 0.0);
+        if (op->have_error) {
+            fprintf(f, " absolute error: %e relative error: %e",
+                    op->abs_error, op->rel_error);
+        }
+        fputc('\n', f);
+    }
+}
@@ -0,0 +1,152 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * Traces of calls to math functions, and their replay.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "mathop.h"
+#include "round.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * A trace file consists of a header followed by records, in the byte
+ * order of the machine that wrote it. The header is written again
+ * when the trace is closed, to record the number of dropped calls.
+ */
+#define TRACE_MAGIC "MBTRACE"
+#define TRACE_VERSION 1
+
+/**
+ * `trace_header` is the header of a trace file.
+ *
+ * Calls are sampled, so that every `period`-th call made by each
+ * thread is recorded. `num_dropped` is the number of sampled calls
+ * that were not recorded, because the ring buffer of the calling
+ * thread was full.
+ */
+struct trace_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_mathops;
+    uint64_t period;
+    uint64_t num_dropped;
+};
+
+/**
+ * `trace_record` is a recorded call to a math function. Arguments of
+ * single-precision functions are stored exactly as doubles.
+ */
+struct trace_record
+{
+    uint32_t mathop;
+    uint32_t thread;
+    double x;
+};
+
+/**
+ * `trace` is a trace of calls to math functions that has been read
+ * from a file.
+ */
+struct trace
+{
+    uint64_t period;
+    uint64_t num_dropped;
+    int num_threads;
+    int64_t num_records;
+    struct trace_record * records;
+};
+
+/**
+ * `trace_read()` reads a trace from a file.
+ *
+ * If the file is not a trace, was written by an incompatible version,
+ * or contains a record of an unknown math operation, then
+ * `trace_read()` returns `EINVAL`.
+ */
+int trace_read(
+    const char * path,
+    struct trace * trace);
+
+/**
+ * `trace_free()` frees resources associated with a trace.
+ */
+void trace_free(
+    struct trace * trace);
+
+/**
+ * `trace_replay_op` is the outcome of replaying the calls to one
+ * math operation in a trace.
+ */
+struct trace_replay_op
+{
+    int64_t num_calls;
+    int64_t num_ops;
+    double seconds;
+    bool have_error;
+    double abs_error;
+    double rel_error;
+};
+
+/**
+ * `trace_replay_result` is the outcome of replaying a trace.
+ */
+struct trace_replay_result
+{
+    int repeat;
+    int64_t num_calls;
+    double seconds;
+    struct trace_replay_op ops[num_mathops];
+};
+
+/**
+ * `trace_replay()` replays the calls in a trace.
+ *
+ * First, all calls are repeated `repeat` times by one thread, in the
+ * order in which they were recorded, to measure the throughput of the
+ * mix of calls. Then, the arguments of each math operation are
+ * benchmarked together with `benchmark_mathop()`, in the same way as
+ * the input of the benchmark, and the error of the results is
+ * computed with MPFR, if it is enabled.
+ */
+int trace_replay(
+    const struct trace * trace,
+    int alignment,
+    int repeat,
+    enum round_mode rounding_mode,
+    int precision,
+    struct trace_replay_result * result);
+
+/**
+ * `trace_replay_print()` prints the throughput of the mix of calls in
+ * a trace, and the share of calls, throughput and error of each math
+ * operation.
+ */
+void trace_replay_print(
+    const struct trace * trace,
+    const struct trace_replay_result * result,
+    FILE * f);
+
+#endif
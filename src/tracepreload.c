@@ -0,0 +1,268 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * An LD_PRELOAD library that records calls to math functions.
+ */
+
+#define _GNU_SOURCE
+
+#include "mathop.h"
+#include "trace.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * The library defines every math function that is benchmarked by
+ * `mbench', and each definition records its argument before calling
+ * the function of the same name in the next library, usually the C
+ * math library. Every `MBENCH_TRACE_PERIOD'-th call made by each
+ * thread is recorded (default: 1), in a ring buffer that belongs to
+ * the thread. A background thread moves the records from the ring
+ * buffers to the file named by `MBENCH_TRACE' (default:
+ * `mbench-trace.PID.bin'), and the remaining records are written when
+ * the program exits. Calls that find the ring buffer of their thread
+ * full are counted, but not recorded.
+ *
+ * Calls that the compiler has replaced by inline code, such as `sqrt'
+ * with `-fno-math-errno', and calls made from within the C math
+ * library itself, are not recorded.
+ */
+
+/* The number of records in the ring buffer of each thread. */
+#define TRACE_RING_SIZE 65536
+
+/**
+ * `trace_ring` is a single-producer, single-consumer ring buffer of
+ * records. The thread that owns the ring advances `head` and the
+ * background thread advances `tail`.
+ */
+struct trace_ring
+{
+    struct trace_ring * next;
+    uint32_t thread;
+    uint64_t num_calls;
+    atomic_uint_fast64_t head;
+    atomic_uint_fast64_t tail;
+    atomic_uint_fast64_t num_dropped;
+    struct trace_record records[TRACE_RING_SIZE];
+};
+
+static _Thread_local struct trace_ring * trace_ring;
+static _Atomic(struct trace_ring *) trace_rings;
+static atomic_uint trace_num_threads;
+static uint64_t trace_period = 1;
+static FILE * trace_file;
+static pthread_t trace_flusher;
+static pthread_once_t trace_flusher_once = PTHREAD_ONCE_INIT;
+static bool trace_flusher_started;
+static atomic_int trace_stop;
+static atomic_int trace_disabled;
+
+/**
+ * `trace_write_header()` writes the header of the trace file at its
+ * start.
+ */
+static void trace_write_header(
+    uint64_t num_dropped)
+{
+    struct trace_header header = {0};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.num_mathops = num_mathops;
+    header.period = trace_period;
+    header.num_dropped = num_dropped;
+    fseek(trace_file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, trace_file);
+}
+
+/**
+ * `trace_drain()` writes the records of every ring buffer to the
+ * trace file and returns the total number of dropped calls.
+ */
+static uint64_t trace_drain(void)
+{
+    uint64_t num_dropped = 0;
+    for (struct trace_ring * ring = atomic_load(&trace_rings);
+         ring; ring = ring->next)
+    {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail < head) {
+            uint64_t i = tail % TRACE_RING_SIZE;
+            uint64_t n = head - tail < TRACE_RING_SIZE - i
+                ? head - tail : TRACE_RING_SIZE - i;
+            fwrite(&ring->records[i], sizeof(struct trace_record), n, trace_file);
+            tail += n;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        num_dropped += atomic_load_explicit(&ring->num_dropped, memory_order_relaxed);
+    }
+    return num_dropped;
+}
+
+/**
+ * `trace_flusher_main()` periodically writes records to the trace
+ * file until the program exits.
+ */
+static void * trace_flusher_main(
+    void * arg)
+{
+    struct timespec interval = {0, 1000000};
+    while (!atomic_load(&trace_stop)) {
+        trace_drain();
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+/**
+ * `trace_start()` opens the trace file and starts the background
+ * thread. If either fails, tracing is disabled.
+ */
+static void trace_start(void)
+{
+    const char * period = getenv("MBENCH_TRACE_PERIOD");
+    if (period && atoll(period) > 0)
+        trace_period = atoll(period);
+
+    char path[64];
+    const char * trace_path = getenv("MBENCH_TRACE");
+    if (!trace_path) {
+        snprintf(path, sizeof(path), "mbench-trace.%d.bin", (int) getpid());
+        trace_path = path;
+    }
+    trace_file = fopen(trace_path, "wb");
+    if (!trace_file) {
+        fprintf(stderr, "%s: %s: %s\n",
+                program_invocation_short_name, trace_path, strerror(errno));
+        atomic_store(&trace_disabled, 1);
+        return;
+    }
+    trace_write_header(0);
+
+    /* Block signals in the background thread. */
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&trace_flusher, NULL, trace_flusher_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err) {
+        fclose(trace_file);
+        trace_file = NULL;
+        atomic_store(&trace_disabled, 1);
+        return;
+    }
+    trace_flusher_started = true;
+}
+
+/**
+ * `trace_thread_ring()` is the ring buffer of the calling thread,
+ * which is created and registered on first use.
+ */
+static struct trace_ring * trace_thread_ring(void)
+{
+    if (trace_ring)
+        return trace_ring;
+    pthread_once(&trace_flusher_once, trace_start);
+    if (atomic_load(&trace_disabled))
+        return NULL;
+    struct trace_ring * ring = calloc(1, sizeof(*ring));
+    if (!ring)
+        return NULL;
+    ring->thread = atomic_fetch_add(&trace_num_threads, 1);
+    struct trace_ring * head = atomic_load(&trace_rings);
+    do {
+        ring->next = head;
+    } while (!atomic_compare_exchange_weak(&trace_rings, &head, ring));
+    trace_ring = ring;
+    return ring;
+}
+
+/**
+ * `trace_record()` records a call made by the calling thread, if it
+ * is sampled and there is room in its ring buffer.
+ */
+static inline void trace_record(
+    enum mathop mathop,
+    double x)
+{
+    struct trace_ring * ring = trace_thread_ring();
+    if (!ring || (ring->num_calls++ % trace_period) != 0)
+        return;
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= TRACE_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->num_dropped, 1, memory_order_relaxed);
+        return;
+    }
+    struct trace_record * r = &ring->records[head % TRACE_RING_SIZE];
+    r->mathop = mathop;
+    r->thread = ring->thread;
+    r->x = x;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+ * `trace_finish()` stops the background thread and writes the
+ * remaining records when the program exits.
+ */
+__attribute__((destructor))
+static void trace_finish(void)
+{
+    if (!trace_flusher_started)
+        return;
+    atomic_store(&trace_stop, 1);
+    pthread_join(trace_flusher, NULL);
+    uint64_t num_dropped = trace_drain();
+    atomic_store(&trace_disabled, 1);
+    trace_write_header(num_dropped);
+    fclose(trace_file);
+}
+
+/*
+ * Definitions of the math functions that record each call and then
+ * call the next definition, which is looked up on first use.
+ */
+
+#define trace_fn(OPNAME, TYPE)                                          \
+    TYPE OPNAME(TYPE x)                                                 \
+    {                                                                   \
+        static _Atomic(TYPE (*)(TYPE)) next;                            \
+        TYPE (* fn)(TYPE) = atomic_load_explicit(&next, memory_order_relaxed); \
+        if (!fn) {                                                      \
+            fn = (TYPE (*)(TYPE)) dlsym(RTLD_NEXT, #OPNAME);            \
+            atomic_store_explicit(&next, fn, memory_order_relaxed);     \
+        }                                                               \
+        trace_record(mathop_ ## OPNAME, x);                             \
+        return fn(x);                                                   \
+    }                                                                   \
+
+mathop_fns(trace_fn)
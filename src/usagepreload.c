@@ -0,0 +1,386 @@
+/*
+ * Benchmark program for common mathematical functions
+ * Copyright (C) 2020 James D. Trotter
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: James D. Trotter <james@simula.no>
+ *
+ * An LD_PRELOAD library that profiles calls to math functions.
+ */
+
+#define _GNU_SOURCE
+
+#include "mathop.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * The library defines every math function that is benchmarked by
+ * `mbench', and each definition counts its calls before calling the
+ * function of the same name in the next library, usually the C math
+ * library. On average, one in `MBENCH_USAGE_PERIOD' calls made by each
+ * thread is also timed with the time-stamp counter (default: 64), at
+ * random intervals, so that periodic patterns of calls are not
+ * aliased. The time spent in each function is estimated from the
+ * timed calls.
+ *
+ * A summary is written to standard error, or appended to the file
+ * named by `MBENCH_USAGE', when the program exits and whenever it
+ * receives `SIGUSR1', unless the program handles that signal itself.
+ */
+
+#define usage_name(OPNAME, TYPE) [mathop_ ## OPNAME] = #OPNAME,
+
+/**
+ * `usage_names` are the names of the profiled math functions.
+ */
+static const char * const usage_names[num_mathops] = {
+    mathop_fns(usage_name)
+};
+
+/**
+ * `usage_counts` are the numbers of calls to a math function made by
+ * one thread, of the calls that were timed, and of time-stamp counter
+ * ticks spent in the timed calls. They are updated by the thread that
+ * owns them and may be read by any thread.
+ */
+struct usage_counts
+{
+    atomic_uint_fast64_t num_calls;
+    atomic_uint_fast64_t num_timed;
+    atomic_uint_fast64_t ticks;
+};
+
+/**
+ * `usage_thread` is the state of a thread that calls math functions.
+ */
+struct usage_thread
+{
+    struct usage_thread * next;
+    uint64_t countdown;
+    uint64_t random;
+    struct usage_counts counts[num_mathops];
+};
+
+static _Thread_local struct usage_thread * usage_thread;
+static _Atomic(struct usage_thread *) usage_threads;
+static pthread_once_t usage_once = PTHREAD_ONCE_INIT;
+static uint64_t usage_period = 64;
+static uint64_t usage_overhead;
+static uint64_t usage_start_ticks;
+static struct timespec usage_start_time;
+static atomic_int usage_signalled;
+static atomic_int usage_disabled;
+
+/**
+ * `usage_ticks()` reads the time-stamp counter, or, if there is none,
+ * the monotonic clock in nanoseconds.
+ */
+static inline uint64_t usage_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    uint64_t tsc = __rdtsc();
+    _mm_lfence();
+    return tsc;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000ull + t.tv_nsec;
+#endif
+}
+
+/**
+ * `usage_add()` adds to a counter that is only updated by one thread.
+ */
+static inline void usage_add(
+    atomic_uint_fast64_t * counter,
+    uint64_t n)
+{
+    atomic_store_explicit(
+        counter, atomic_load_explicit(counter, memory_order_relaxed) + n,
+        memory_order_relaxed);
+}
+
+/**
+ * `usage_entry` is the estimated usage of a math function, summed
+ * over all threads.
+ */
+struct usage_entry
+{
+    int mathop;
+    uint64_t num_calls;
+    double seconds;
+};
+
+/**
+ * `compare_usage_entries()` orders math functions by decreasing
+ * estimated time, then by decreasing number of calls.
+ */
+static int compare_usage_entries(
+    const void * a,
+    const void * b)
+{
+    const struct usage_entry * x = a;
+    const struct usage_entry * y = b;
+    if (x->seconds != y->seconds)
+        return x->seconds > y->seconds ? -1 : 1;
+    if (x->num_calls != y->num_calls)
+        return x->num_calls > y->num_calls ? -1 : 1;
+    return x->mathop - y->mathop;
+}
+
+/**
+ * `usage_print()` prints the number of calls, the estimated share of
+ * time spent in math functions, and the average time per call of each
+ * math function that was called.
+ */
+static void usage_print(
+    const char * reason)
+{
+    /* Measure the rate of the time-stamp counter since start-up. */
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    uint64_t ticks = usage_ticks();
+    double elapsed = (t.tv_sec - usage_start_time.tv_sec) +
+        (t.tv_nsec - usage_start_time.tv_nsec) * 1e-9;
+    double seconds_per_tick = ticks > usage_start_ticks && elapsed > 0
+        ? elapsed / (ticks - usage_start_ticks) : 0.0;
+
+    struct usage_entry entries[num_mathops];
+    uint64_t total_calls = 0;
+    double total_seconds = 0;
+    int num_entries = 0;
+    for (int m = 0; m < num_mathops; m++) {
+        uint64_t num_calls = 0, num_timed = 0, ticks = 0;
+        for (struct usage_thread * thread = atomic_load(&usage_threads);
+             thread; thread = thread->next)
+        {
+            const struct usage_counts * c = &thread->counts[m];
+            num_calls += atomic_load_explicit(&c->num_calls, memory_order_relaxed);
+            num_timed += atomic_load_explicit(&c->num_timed, memory_order_relaxed);
+            ticks += atomic_load_explicit(&c->ticks, memory_order_relaxed);
+        }
+        if (num_calls == 0)
+            continue;
+        double ticks_per_call = num_timed > 0 ? (double) ticks / num_timed : 0.0;
+        ticks_per_call = ticks_per_call > usage_overhead
+            ? ticks_per_call - usage_overhead : 0.0;
+        entries[num_entries].mathop = m;
+        entries[num_entries].num_calls = num_calls;
+        entries[num_entries].seconds = num_calls * ticks_per_call * seconds_per_tick;
+        total_calls += num_calls;
+        total_seconds += entries[num_entries].seconds;
+        num_entries++;
+    }
+    qsort(entries, num_entries, sizeof(*entries), compare_usage_entries);
+
+    const char * path = getenv("MBENCH_USAGE");
+    FILE * f = path ? fopen(path, "a") : stderr;
+    if (!f)
+        return;
+    fprintf(f, "mbench-usage: %s %d (%s): %.3e math calls, "
+            "%.6f seconds estimated in math functions, %.6f seconds elapsed\n",
+            program_invocation_short_name, (int) getpid(), reason,
+            (double) total_calls, total_seconds, elapsed);
+    for (int i = 0; i < num_entries; i++) {
+        const struct usage_entry * e = &entries[i];
+        fprintf(f, "mbench-usage: %s %.1f%% of math time, %.3e calls, "
+                "%.1f ns avg\n",
+                usage_names[e->mathop],
+                total_seconds > 0 ? 100.0 * e->seconds / total_seconds : 0.0,
+                (double) e->num_calls, 1e9 * e->seconds / e->num_calls);
+    }
+    fflush(f);
+    if (f != stderr)
+        fclose(f);
+}
+
+/**
+ * `usage_signal()` handles `SIGUSR1` by asking the background thread
+ * to print a summary.
+ */
+static void usage_signal(
+    int signum)
+{
+    atomic_store(&usage_signalled, 1);
+}
+
+/**
+ * `usage_reporter_main()` prints a summary whenever the program has
+ * received `SIGUSR1`.
+ */
+static void * usage_reporter_main(
+    void * arg)
+{
+    struct timespec interval = {0, 100000000};
+    while (true) {
+        nanosleep(&interval, NULL);
+        if (atomic_exchange(&usage_signalled, 0))
+            usage_print("SIGUSR1");
+    }
+    return NULL;
+}
+
+/**
+ * `usage_start()` reads the sampling period, measures the cost of
+ * reading the time-stamp counter, and, unless the program handles
+ * `SIGUSR1` itself, installs a handler and starts a background thread
+ * to report on request.
+ */
+static void usage_start(void)
+{
+    const char * period = getenv("MBENCH_USAGE_PERIOD");
+    if (period && atoll(period) > 0)
+        usage_period = atoll(period);
+
+    uint64_t overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t t0 = usage_ticks();
+        uint64_t t1 = usage_ticks();
+        if (overhead > t1 - t0)
+            overhead = t1 - t0;
+    }
+    usage_overhead = overhead;
+
+    struct sigaction old;
+    if (sigaction(SIGUSR1, NULL, &old) == 0 && old.sa_handler == SIG_DFL) {
+        sigset_t all, mask;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &mask);
+        pthread_t reporter;
+        int err = pthread_create(&reporter, NULL, usage_reporter_main, NULL);
+        pthread_sigmask(SIG_SETMASK, &mask, NULL);
+        if (!err) {
+            pthread_detach(reporter);
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = usage_signal;
+            sa.sa_flags = SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            sigaction(SIGUSR1, &sa, NULL);
+        }
+    }
+}
+
+/**
+ * `usage_init()` records the time of start-up, against which the
+ * rate of the time-stamp counter is measured.
+ */
+__attribute__((constructor))
+static void usage_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &usage_start_time);
+    usage_start_ticks = usage_ticks();
+}
+
+/**
+ * `usage_next_countdown()` is a random number of calls until the next
+ * timed call, uniformly distributed in `[0, 2*period-2]`, so that the
+ * average interval between timed calls is `period`.
+ */
+static inline uint64_t usage_next_countdown(
+    struct usage_thread * thread)
+{
+    thread->random ^= thread->random << 13;
+    thread->random ^= thread->random >> 7;
+    thread->random ^= thread->random << 17;
+    return usage_period > 1 ? thread->random % (2*usage_period - 1) : 0;
+}
+
+/**
+ * `usage_get_thread()` is the state of the calling thread, which is
+ * created and registered on first use.
+ */
+static struct usage_thread * usage_get_thread(void)
+{
+    if (usage_thread)
+        return usage_thread;
+    if (atomic_load(&usage_disabled))
+        return NULL;
+    pthread_once(&usage_once, usage_start);
+    struct usage_thread * thread = calloc(1, sizeof(*thread));
+    if (!thread)
+        return NULL;
+    thread->random = 0x9e3779b97f4a7c15ull ^ (uintptr_t) thread;
+    thread->countdown = usage_next_countdown(thread);
+    struct usage_thread * head = atomic_load(&usage_threads);
+    do {
+        thread->next = head;
+    } while (!atomic_compare_exchange_weak(&usage_threads, &head, thread));
+    usage_thread = thread;
+    return thread;
+}
+
+/**
+ * `usage_finish()` prints a summary when the program exits.
+ */
+__attribute__((destructor))
+static void usage_finish(void)
+{
+    atomic_store(&usage_disabled, 1);
+    if (atomic_load(&usage_threads))
+        usage_print("exit");
+}
+
+/*
+ * Definitions of the math functions that count and time calls, and
+ * then call the next definition, which is looked up on first use.
+ */
+
+#define usage_fn(OPNAME, TYPE)                                          \
+    TYPE OPNAME(TYPE x)                                                 \
+    {                                                                   \
+        static _Atomic(TYPE (*)(TYPE)) next;                            \
+        TYPE (* fn)(TYPE) = atomic_load_explicit(&next, memory_order_relaxed); \
+        if (!fn) {                                                      \
+            fn = (TYPE (*)(TYPE)) dlsym(RTLD_NEXT, #OPNAME);            \
+            atomic_store_explicit(&next, fn, memory_order_relaxed);     \
+        }                                                               \
+        struct usage_thread * thread = usage_get_thread();              \
+        if (!thread)                                                    \
+            return fn(x);                                               \
+        struct usage_counts * c = &thread->counts[mathop_ ## OPNAME];   \
+        usage_add(&c->num_calls, 1);                                    \
+        if (thread->countdown > 0) {                                    \
+            thread->countdown--;                                        \
+            return fn(x);                                               \
+        }                                                               \
+        thread->countdown = usage_next_countdown(thread);               \
+        uint64_t t0 = usage_ticks();                                    \
+        TYPE y = fn(x);                                                 \
+        uint64_t t1 = usage_ticks();                                    \
+        usage_add(&c->num_timed, 1);                                    \
+        usage_add(&c->ticks, t1 - t0);                                  \
+        return y;                                                       \
+    }                                                                   \
+
+mathop_fns(usage_fn)